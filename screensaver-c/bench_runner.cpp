@@ -1,13 +1,28 @@
 // bench_runner.cpp
 // Compilar: g++ -std=c++17 -O2 bench_runner.cpp -o bench_runner
+//
+// Barrido de escalamiento sobre hilos, N, resoluciones y schedules de OpenMP.
+// Cada combinación se corre 'runs' veces (más una de calentamiento que se descarta)
+// y se reporta mediana, media, desviación, mínimo e intervalo de confianza del 95%.
+// Los binarios se llaman con --bench-json y se lee su línea BENCH_JSON {...}.
+// Ambos binarios son el mismo núcleo: el paralelo se corre con cada --backends= pedido
+// (omp, pool, stdpar) y el secuencial es la base de los speedups.
+//
+// Ejemplo:
+//   ./bench_runner --threads=1,2,4,8 --N=20000,200000 --res=960x540,1920x1080
+//                  --backends=omp,pool --schedules=static,dynamic --mode=sim --runs=10 --weak=20000 --csv=res.csv
 #include <iostream>
+#include <fstream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <cstdio>
 #include <cstdlib>
+#include <cmath>
 #include <regex>
 #include <numeric>
+#include <algorithm>
 #include <map>
 
 // Ejecuta un comando y devuelve su salida como string
@@ -18,7 +33,6 @@ std::string execCmd(const std::string& cmd,
     char buffer[256];
 
     // Construir entorno combinado
-    std::string env_str;
     for (auto& kv : env_extra) {
 #ifdef _WIN32
         _putenv_s(kv.first.c_str(), kv.second.c_str());
@@ -44,7 +58,7 @@ std::string execCmd(const std::string& cmd,
     return result;
 }
 
-// Extrae "Tiempo total: X ms"
+// Extrae "Tiempo total: X ms" (binarios viejos, sin --bench-json)
 double parseTime(const std::string& text) {
     std::regex re(R"(Tiempo\s+total:\s*([0-9]+(?:[.,][0-9]+)?)\s*ms)");
     std::smatch m;
@@ -56,16 +70,168 @@ double parseTime(const std::string& text) {
     return -1.0;
 }
 
-std::vector<double> runBench(const std::string& bin, int frames, int runs,
-                             const std::map<std::string,std::string>& env = {}) {
+// Busca "key":<número> en la línea BENCH_JSON (JSON plano de una línea, sin anidar)
+double jsonNumber(const std::string& line, const std::string& key) {
+    std::string pat = "\"" + key + "\":";
+    size_t p = line.find(pat);
+    if (p == std::string::npos) return -1.0;
+    try { return std::stod(line.substr(p + pat.size())); } catch (...) { return -1.0; }
+}
+
+// Tiempo promedio por frame (ms) de una corrida, o -1 si falló
+double parseAvgMs(const std::string& out, int frames) {
+    size_t p = out.find("BENCH_JSON ");
+    if (p != std::string::npos) {
+        std::string line = out.substr(p, out.find('\n', p) - p);
+        return jsonNumber(line, "avg_ms");
+    }
+    double t = parseTime(out);
+    return (t > 0) ? t / frames : -1.0;
+}
+
+// ---------------- Estadística ----------------
+struct Stats {
+    int n = 0;
+    double median = -1, mean = -1, stddev = 0, min = -1, ci95 = 0; // ci95: semiancho del IC de la media
+};
+
+// t de Student de dos colas al 95% para gl = 1..30 (después ~normal)
+double tCrit95(int df) {
+    static const double t[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if (df < 1) return 0.0;
+    return (df <= 30) ? t[df - 1] : 1.960;
+}
+
+Stats computeStats(std::vector<double> v) {
+    Stats s;
+    s.n = (int)v.size();
+    if (v.empty()) return s;
+    std::sort(v.begin(), v.end());
+    s.min = v.front();
+    s.median = (s.n % 2) ? v[s.n / 2] : 0.5 * (v[s.n / 2 - 1] + v[s.n / 2]);
+    s.mean = std::accumulate(v.begin(), v.end(), 0.0) / s.n;
+    if (s.n > 1) {
+        double ss = 0.0;
+        for (double x : v) ss += (x - s.mean) * (x - s.mean);
+        s.stddev = std::sqrt(ss / (s.n - 1));
+        s.ci95 = tCrit95(s.n - 1) * s.stddev / std::sqrt(double(s.n));
+    }
+    return s;
+}
+
+// ---------------- Configuración del barrido ----------------
+struct Config {
+#ifdef _WIN32
+    std::string seqBin = "secuencial\\screensaver.exe";
+    std::string parBin = "paralelo\\screensaver.exe";
+#else
+    std::string seqBin = "./secuencial/screensaver";
+    std::string parBin = "./paralelo/screensaver";
+#endif
+    std::vector<int> threads = {1, 2, 4, 8};
+    std::vector<int> Ns = {20000};
+    std::vector<std::pair<int,int>> res = {{960, 540}};
+    std::vector<std::string> schedules = {"static"};
+    std::vector<std::string> backends = {"omp"};    // --backend= del binario paralelo
+    std::string mode = "sim";          // sim | raster | full
+    int frames = 200, runs = 10;
+    int weakPerThread = 0;             // >0: barrido de escalamiento débil con N = weak*hilos
+    unsigned long long seed = 12345;   // misma semilla en todas las corridas
+    std::string csv;                   // si no está vacío: todas las corridas crudas
+    bool noSeq = false;
+};
+
+bool startsWith(const std::string& s, const std::string& pre){ return s.rfind(pre,0)==0; }
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+std::vector<int> parseIntList(const std::string& s) {
+    std::vector<int> out;
+    for (const std::string& it : splitList(s)) {
+        try { out.push_back(std::max(1, std::stoi(it))); } catch (...) { std::cerr << "[warn] valor invalido: " << it << "\n"; }
+    }
+    return out;
+}
+
+void parseArgs(int argc, char** argv, Config& C) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if      (startsWith(a,"--seq="))       C.seqBin = a.substr(6);
+        else if (startsWith(a,"--par="))       C.parBin = a.substr(6);
+        else if (startsWith(a,"--threads="))   C.threads = parseIntList(a.substr(10));
+        else if (startsWith(a,"--N="))         C.Ns = parseIntList(a.substr(4));
+        else if (startsWith(a,"--schedules=")) C.schedules = splitList(a.substr(12));
+        else if (startsWith(a,"--backends="))  C.backends = splitList(a.substr(11));
+        else if (startsWith(a,"--mode="))      C.mode = a.substr(7);
+        else if (startsWith(a,"--frames="))    C.frames = std::max(1, std::atoi(a.substr(9).c_str()));
+        else if (startsWith(a,"--runs="))      C.runs = std::max(1, std::atoi(a.substr(7).c_str()));
+        else if (startsWith(a,"--weak="))      C.weakPerThread = std::max(0, std::atoi(a.substr(7).c_str()));
+        else if (startsWith(a,"--seed="))      C.seed = std::strtoull(a.substr(7).c_str(), nullptr, 10);
+        else if (startsWith(a,"--csv="))       C.csv = a.substr(6);
+        else if (a == "--no-seq")              C.noSeq = true;
+        else if (startsWith(a,"--res=")) {
+            C.res.clear();
+            for (const std::string& r : splitList(a.substr(6))) {
+                int w = 0, h = 0;
+                if (std::sscanf(r.c_str(), "%dx%d", &w, &h) == 2) C.res.push_back({w, h});
+                else std::cerr << "[warn] resolucion invalida: " << r << "\n";
+            }
+        }
+        else std::cerr << "[warn] argumento desconocido: " << a << "\n";
+    }
+    if (C.threads.empty()) C.threads = {1};
+    if (C.Ns.empty()) C.Ns = {20000};
+    if (C.res.empty()) C.res = {{960, 540}};
+    if (C.schedules.empty()) C.schedules = {"static"};
+    if (C.backends.empty()) C.backends = {"omp"};
+}
+
+// Combinaciones backend x schedule a correr; el schedule solo importa con omp
+struct Variant { std::string backend, sched, label; };
+
+std::vector<Variant> variants(const Config& C) {
+    std::vector<Variant> out;
+    for (const std::string& b : C.backends) {
+        if (b == "omp") for (const std::string& sc : C.schedules) out.push_back({b, sc, b + " " + sc});
+        else out.push_back({b, C.schedules.front(), b});
+    }
+    return out;
+}
+
+// ---------------- Corridas ----------------
+std::ofstream gCsv;
+
+std::vector<double> runBench(const Config& C, const std::string& bin, const std::string& label,
+                             int N, int W, int H, const std::map<std::string,std::string>& env = {},
+                             const std::string& backend = "") {
+    std::ostringstream cmd;
+    cmd << bin << " --bench-mode=" << C.mode << " --bench-json --frames=" << C.frames
+        << " --N=" << N << " --width=" << W << " --height=" << H << " --seed=" << C.seed;
+    if (!backend.empty()) cmd << " --backend=" << backend;
+
     std::vector<double> times;
-    for (int i = 0; i < runs; i++) {
-        std::string cmd = bin + " --benchmark --frames=" + std::to_string(frames);
-        std::string out = execCmd(cmd, env);
-        double t = parseTime(out);
+    execCmd(cmd.str(), env); // calentamiento (caché, frecuencia de CPU), se descarta
+    for (int i = 0; i < C.runs; i++) {
+        std::string out = execCmd(cmd.str(), env);
+        double t = parseAvgMs(out, C.frames);
         if (t > 0) {
             times.push_back(t);
-            std::cout << "  Run " << (i+1) << ": " << t << " ms\n";
+            if (gCsv) {
+                auto th = env.find("OMP_NUM_THREADS");
+                auto sc = env.find("OMP_SCHEDULE");
+                gCsv << label << ',' << (backend.empty() ? "serial" : backend) << ','
+                     << (th != env.end() ? th->second : "1") << ','
+                     << (sc != env.end() ? sc->second : "-") << ',' << N << ',' << W << 'x' << H << ','
+                     << C.mode << ',' << (i + 1) << ',' << t << '\n';
+            }
         } else {
             std::cout << "  Run " << (i+1) << ": FAIL\n";
             std::cerr << out << "\n"; // para debug
@@ -74,39 +240,93 @@ std::vector<double> runBench(const std::string& bin, int frames, int runs,
     return times;
 }
 
-double mean(const std::vector<double>& v) {
-    if (v.empty()) return -1.0;
-    return std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+void printStatsRow(const std::string& label, const Stats& s) {
+    std::cout << "  " << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(3)
+              << " med " << std::setw(9) << s.median << "  media " << std::setw(9) << s.mean
+              << " ±" << std::setw(7) << s.ci95 << "  sd " << std::setw(7) << s.stddev
+              << "  min " << std::setw(9) << s.min << " ms/frame  (n=" << s.n << ")\n";
 }
 
-int main() {
-    const std::string seqBin = "secuencial\\screensaver.exe";
-    const std::string parBin = "paralelo\\screensaver.exe";
-    int frames = 500, runs = 10;
+int main(int argc, char** argv) {
+    Config C;
+    parseArgs(argc, argv, C);
 
-    std::cout << "== Benchmark Screensaver ==\n";
+    if (!C.csv.empty()) {
+        gCsv.open(C.csv);
+        if (gCsv) gCsv << "binary,backend,threads,schedule,N,res,mode,run,avg_ms\n";
+        else std::cerr << "[warn] no se pudo abrir " << C.csv << "\n";
+    }
 
-    std::cout << "\n>> Secuencial:\n";
-    auto t_seq = runBench(seqBin, frames, runs);
+    std::cout << "== Benchmark Screensaver ==  modo: " << C.mode << "  frames: " << C.frames
+              << "  corridas: " << C.runs << " (+1 calentamiento)\n";
 
-    std::cout << "\n>> Paralelo (4 hilos):\n";
-    auto t_par4 = runBench(parBin, frames, runs, {{"OMP_NUM_THREADS","4"}});
+    // ---- Escalamiento fuerte: N fijo, más hilos ----
+    for (auto [W, H] : C.res) {
+        for (int N : C.Ns) {
+            std::cout << "\n>> N=" << N << "  " << W << "x" << H << "\n";
 
-    std::cout << "\n>> Paralelo (8 hilos):\n";
-    auto t_par8 = runBench(parBin, frames, runs, {{"OMP_NUM_THREADS","8"}});
+            Stats seq;
+            if (!C.noSeq) {
+                seq = computeStats(runBench(C, C.seqBin, "seq", N, W, H));
+                printStatsRow("secuencial", seq);
+            }
 
-    double avg_seq  = mean(t_seq);
-    double avg_par4 = mean(t_par4);
-    double avg_par8 = mean(t_par8);
+            for (const Variant& v : variants(C)) {
+                std::vector<std::pair<int, Stats>> rows;
+                for (int t : C.threads) {
+                    Stats s = computeStats(runBench(C, C.parBin, "par", N, W, H,
+                        {{"OMP_NUM_THREADS", std::to_string(t)}, {"OMP_SCHEDULE", v.sched}}, v.backend));
+                    printStatsRow(v.label + " " + std::to_string(t) + "h", s);
+                    rows.push_back({t, s});
+                }
 
-    std::cout << "\n== Resumen Promedios ==\n";
-    std::cout << "Secuencial: " << avg_seq  << " ms\n";
-    if (avg_par4 > 0)
-        std::cout << "Par (4 hilos): " << avg_par4 << " ms  | Speedup=" 
-                  << (avg_seq/avg_par4) << "  Eff=" << (avg_seq/avg_par4/4) << "\n";
-    if (avg_par8 > 0)
-        std::cout << "Par (8 hilos): " << avg_par8 << " ms  | Speedup=" 
-                  << (avg_seq/avg_par8) << "  Eff=" << (avg_seq/avg_par8/8) << "\n";
+                // Base: secuencial si existe, si no el paralelo con menos hilos
+                double base = (seq.n > 0) ? seq.median : -1.0;
+                std::string baseName = "secuencial";
+                if (base <= 0 && !rows.empty() && rows.front().second.n > 0) {
+                    base = rows.front().second.median * rows.front().first;
+                    baseName = v.label + " " + std::to_string(rows.front().first) + "h (x hilos)";
+                }
+                if (base <= 0) continue;
+
+                std::cout << "  Escalamiento fuerte (" << v.label << ", base " << baseName << ", medianas):\n"
+                          << "    hilos   ms/frame   speedup   eficiencia\n";
+                for (auto& [t, s] : rows) {
+                    if (s.n == 0) continue;
+                    double sp = base / s.median;
+                    std::cout << "    " << std::setw(5) << t << "  " << std::setw(9) << std::setprecision(3) << s.median
+                              << "  " << std::setw(8) << std::setprecision(2) << sp
+                              << "  " << std::setw(10) << std::setprecision(2) << (sp / t) << "\n";
+                }
+            }
+        }
+    }
+
+    // ---- Escalamiento débil: N = weak*hilos, tiempo ideal constante ----
+    if (C.weakPerThread > 0) {
+        auto [W, H] = C.res.front();
+        for (const Variant& v : variants(C)) {
+            std::cout << "\n>> Escalamiento debil: " << C.weakPerThread << " satelites/hilo  " << W << "x" << H
+                      << "  " << v.label << "\n";
+            std::vector<std::pair<int, Stats>> rows;
+            for (int t : C.threads) {
+                int N = C.weakPerThread * t;
+                Stats s = computeStats(runBench(C, C.parBin, "par-weak", N, W, H,
+                    {{"OMP_NUM_THREADS", std::to_string(t)}, {"OMP_SCHEDULE", v.sched}}, v.backend));
+                printStatsRow(v.label + " " + std::to_string(t) + "h N=" + std::to_string(N), s);
+                rows.push_back({t, s});
+            }
+            if (rows.empty() || rows.front().second.n == 0) continue;
+            const double t1 = rows.front().second.median;
+            std::cout << "    hilos   ms/frame   eficiencia (T1/Tp)\n";
+            for (auto& [t, s] : rows) {
+                if (s.n == 0) continue;
+                std::cout << "    " << std::setw(5) << t << "  " << std::setw(9) << std::setprecision(3) << s.median
+                          << "  " << std::setw(10) << std::setprecision(2) << (t1 / s.median) << "\n";
+            }
+        }
+    }
 
+    if (gCsv) std::cout << "\nCorridas crudas en " << C.csv << "\n";
     return 0;
 }
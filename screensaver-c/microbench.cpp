@@ -0,0 +1,229 @@
+// microbench.cpp
+// Microbenchmarks de los kernels de física y raster, aislados del loop de frames.
+// Compilar (desde screensaver-c/):
+//   g++ -O2 -std=c++17 -fopenmp microbench.cpp -o microbench $(pkg-config --cflags --libs sdl2 SDL2_ttf)
+//
+// Cada kernel se corre sobre tres distribuciones de satélites:
+//   uniform  : toda la pantalla, sin cooldown
+//   cluster  : amontonados alrededor de los principales (muchas eyecciones)
+//   cooldown : toda la pantalla, todos en cooldown (gravedad parcial, sin eyección)
+// y se reporta ns/partícula, bytes/partícula (tráfico estimado de los arreglos SoA)
+// y el ancho de banda resultante. Se toma el mínimo de --reps repeticiones, cada una
+// sobre una copia limpia del estado (la copia no se mide). Todos los kernels corren
+// repartidos en bloques de kSatGrain con parallelFor sobre --threads hilos.
+//
+//   ./microbench --N=10000,100000,1000000 --mains=4 --reps=5 --threads=1
+#define SCREENSAVER_NO_MAIN
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wunused-function"   // menú, SDL, etc. no se usan acá
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+#include "paralelo/main_par.cpp"
+
+#include <functional>
+#include <sstream>
+
+enum class Dist { UNIFORM, CLUSTER, COOLDOWN };
+static const char* distLabel(Dist d) {
+    switch (d) {
+        case Dist::UNIFORM: return "uniform";
+        case Dist::CLUSTER: return "cluster";
+        default:            return "cooldown";
+    }
+}
+
+// Estado con los principales de initSim y los satélites según la distribución
+static void makeState(SimState& S, const SimParams& p, Dist d) {
+    SimParams q = p; q.N = 0;
+    initSim(S, q);
+    SatArray& sat = S.sats;
+    sat.radius = p.satRadius; sat.mass = p.satMass;
+    sat.resize(p.N);
+    const int nm = (int)S.mains.size();
+    for (int i = 0; i < p.N; i++) {
+        CounterRng rng(p.seed, kRngSats, Uint64(i));
+        if (d == Dist::CLUSTER && nm > 0) {
+            const Body& M = S.mains[rng.next() % nm];
+            float ang = rng.uniform(0.f, 6.2831853f);
+            float r   = rng.uniform(0.f, 3.f * M.radius);
+            sat.x[i] = clampf(M.x + r * std::cos(ang), 0.f, float(p.width));
+            sat.y[i] = clampf(M.y + r * std::sin(ang), 0.f, float(p.height));
+        } else {
+            sat.x[i] = rng.uniform(0.f, float(p.width));
+            sat.y[i] = rng.uniform(0.f, float(p.height));
+        }
+        sat.vx[i] = rng.uniform(-p.maxInitSpeed, p.maxInitSpeed);
+        sat.vy[i] = rng.uniform(-p.maxInitSpeed, p.maxInitSpeed);
+        sat.cooldown[i] = (d == Dist::COOLDOWN) ? rng.uniform(0.05f, p.ejectCooldownSec) : 0.f;
+        sat.color[i] = packRGBA(200, 200, 220, 255);
+    }
+    packMains(S, p);
+}
+
+// Mínimo de 'reps' corridas de fn() en ms; reset() (no medido) restaura el estado antes de cada una
+static double timeMin(int reps, const std::function<void()>& reset, const std::function<void()>& fn) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        reset();
+        double t0 = omp_get_wtime();
+        fn();
+        best = std::min(best, (omp_get_wtime() - t0) * 1000.0);
+    }
+    return best;
+}
+
+// fn(begin, end) sobre [0, n) en bloques, con los hilos de --threads (igual que step())
+static void blocks(int n, const std::function<void(int, int)>& fn) {
+    parallelFor(Backend::OMP, n, kSatGrain, fn);
+}
+
+static void printRow(const char* kernel, Dist d, int n, double ms, double bytesPer) {
+    const double nsPer = ms * 1e6 / n;
+    const double gbs = (ms > 0.0) ? bytesPer * n / (ms * 1e6) : 0.0;
+    std::cout << std::left << std::setw(18) << kernel << std::setw(10) << distLabel(d) << std::right
+              << std::setw(9) << n << std::fixed << std::setprecision(3)
+              << std::setw(11) << nsPer << std::setw(9) << std::setprecision(1) << bytesPer
+              << std::setw(9) << std::setprecision(2) << gbs << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> Ns = {10000, 100000, 1000000};
+    int reps = 5, threads = 1;
+    SimParams P;
+    P.seed = 12345;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (startsWith(a, "--N=")) {
+            Ns.clear();
+            std::stringstream ss(a.substr(4)); std::string it;
+            while (std::getline(ss, it, ',')) Ns.push_back(std::max(1, toInt(it, 1)));
+        }
+        else if (startsWith(a, "--reps="))    reps = std::max(1, toInt(a.substr(7), reps));
+        else if (startsWith(a, "--threads=")) threads = std::max(1, toInt(a.substr(10), threads));
+        else if (startsWith(a, "--mains="))   P.numMains = std::max(0, std::min(kMaxMains, toInt(a.substr(8), P.numMains)));
+        else if (startsWith(a, "--width="))  P.width  = std::max(640, toInt(a.substr(8), P.width));
+        else if (startsWith(a, "--height=")) P.height = std::max(480, toInt(a.substr(9), P.height));
+        else std::cerr << "[warn] argumento desconocido: " << a << "\n";
+    }
+    omp_set_num_threads(threads);
+    const float dt = 1.f / P.simHz;
+
+    std::cout << "microbench  mains: " << P.numMains << "  " << P.width << "x" << P.height
+              << "  hilos: " << threads << "  reps: " << reps << "  (mínimo)\n";
+    std::cout << std::left << std::setw(18) << "kernel" << std::setw(10) << "dist" << std::right
+              << std::setw(9) << "N" << std::setw(11) << "ns/part" << std::setw(9) << "B/part"
+              << std::setw(9) << "GB/s" << "\n";
+
+    const Dist dists[] = { Dist::UNIFORM, Dist::CLUSTER, Dist::COOLDOWN };
+    AlignedVec<Uint32> frame((size_t)P.width * P.height);
+    double sink = 0.0;   // evita que el compilador descarte los resultados
+
+    for (int n : Ns) {
+        P.N = n;
+        for (Dist d : dists) {
+            SimState base, S;
+            makeState(base, P, d);
+            auto reset = [&]{ S = base; };
+            SatArray* sat = &S.sats;
+            const float rad = base.sats.radius;
+
+            // Gravedad de principales: lee x,y,cd,vx,vy y escribe vx,vy
+            double ms = timeMin(reps, reset, [&]{
+                blocks(n, [&](int b, int e) {
+                    for (int i = b; i < e; i++)
+                        applyGravityFromMains(sat->x[i], sat->y[i], sat->cooldown[i], sat->vx[i], sat->vy[i], S.mainsSoA, P, dt);
+                });
+            });
+            printRow("gravityFromMains", d, n, ms, 7 * sizeof(float));
+            sink += S.sats.vx[n / 2];
+
+            // Eyección con índice por grilla: x,y,vx,vy,cd leídos y (si hay choque) escritos
+            ms = timeMin(reps, reset, [&]{
+                blocks(n, [&](int b, int e) {
+                    for (int i = b; i < e; i++)
+                        checkEjectNearby(sat->x[i], sat->y[i], sat->vx[i], sat->vy[i], sat->cooldown[i], rad, S, P);
+                });
+            });
+            printRow("checkEjectNearby", d, n, ms, 10 * sizeof(float));
+            sink += S.sats.x[n / 2];
+
+            // Rebote en paredes: x,y,vx,vy leídos y escritos
+            ms = timeMin(reps, reset, [&]{
+                blocks(n, [&](int b, int e) {
+                    for (int i = b; i < e; i++)
+                        bounceWalls(sat->x[i], sat->y[i], sat->vx[i], sat->vy[i], rad, P);
+                });
+            });
+            printRow("bounceWalls", d, n, ms, 8 * sizeof(float));
+            sink += S.sats.y[n / 2];
+
+            // Colisión elástica entre cuerpos: pares (2k, 2k+1) con las posiciones de los satélites;
+            // cada Body se lee y se escribe completo
+            std::vector<Body> bodies(n & ~1), work;
+            for (int i = 0; i < (int)bodies.size(); i++) {
+                Body& b = bodies[i];
+                b.x = base.sats.x[i]; b.y = base.sats.y[i];
+                b.vx = base.sats.vx[i]; b.vy = base.sats.vy[i];
+                b.radius = P.mainRadiusA; b.mass = P.mainMassA;
+            }
+            ms = timeMin(reps, [&]{ work = bodies; }, [&]{
+                blocks((int)work.size() / 2, [&](int b, int e) {
+                    for (int k = b; k < e; k++) resolveElasticCollision(work[2 * k], work[2 * k + 1]);
+                });
+            });
+            printRow("elasticCollision", d, std::max(1, (int)work.size()), ms, 2.0 * sizeof(Body));
+            if (!work.empty()) sink += work[0].vx;
+
+            // Kernel completo de satélites por nivel SIMD disponible (x,y,vx,vy,cd leídos y escritos)
+            const SimdLevel best = detectSimd();
+            for (SimdLevel lvl : { SimdLevel::SCALAR, SimdLevel::SSE, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+                if (int(lvl) > int(best)) break;
+                const SatKernelFn kernel = satKernelFor(lvl);
+                ms = timeMin(reps, reset, [&]{ blocks(n, [&](int b, int e) { kernel(*sat, b, e, S, P, dt); }); });
+                std::string name = std::string("satKernel/") + simdLabel(lvl);
+                printRow(name.c_str(), d, n, ms, 10 * sizeof(float));
+                sink += S.sats.x[n / 3];
+            }
+
+            // Kernel compacto (--compact=16|32): x,y en punto fijo, vx,vy en half y cd en un
+            // byte, leídos y escritos; escalar y, si la CPU lo tiene, AVX2+F16C
+            for (int bits : { 16, 32 }) {
+                SimState cbase = base, C;
+                cbase.sats.clear();
+                CompactSats& cs = cbase.compact;
+                compactSetup(cs, bits, P);
+                cs.resize(n);
+                for (int i = 0; i < n; i++)
+                    compactStore(cs, i, base.sats.x[i], base.sats.y[i], base.sats.vx[i], base.sats.vy[i],
+                                 base.sats.cooldown[i], 0, P);
+                const double bytes = 2.0 * (2 * (bits / 8) + 2 * sizeof(Uint16) + 1);
+                const CompactKernelFn scalar = compactKernelFor(bits, SimdLevel::SCALAR);
+                const CompactKernelFn fast = compactKernelFor(bits, best);
+                for (CompactKernelFn kernel : { scalar, fast }) {
+                    ms = timeMin(reps, [&]{ C = cbase; }, [&]{
+                        blocks(n, [&](int b, int e) { kernel(C.compact, b, e, C, P, dt); });
+                    });
+                    std::string name = "compact" + std::to_string(bits) + (kernel == scalar ? "/scalar" : "/avx2");
+                    printRow(name.c_str(), d, n, ms, bytes);
+                    sink += C.compact.vx[n / 3];
+                    if (fast == scalar) break;
+                }
+            }
+
+            // Relleno de círculos (raster por tiles): x,y,color + ~pi*r^2 pixeles escritos
+            const DrawView v = viewOf(base);
+            ms = timeMin(reps, []{}, [&]{ rasterSats(frame.data(), v, P); });
+            const double r = std::lround(rad);
+            printRow("rasterSats", d, n, ms, 3 * sizeof(float) + 3.14159 * r * r * sizeof(Uint32));
+            sink += frame[frame.size() / 2];
+
+            // Mapa de densidad: x,y + un contador por satélite (la mezcla y el tone-map van por píxel)
+            const Uint32 bg = packRGBA(10, 14, 20, 255);
+            ms = timeMin(reps, []{}, [&]{ rasterDensity(frame.data(), v, P, bg); });
+            printRow("rasterDensity", d, n, ms, 2 * sizeof(float) + sizeof(Uint32));
+            sink += frame[frame.size() / 2];
+        }
+    }
+    std::cout << "(checksum " << sink << ")\n";
+    return 0;
+}
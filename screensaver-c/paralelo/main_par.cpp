@@ -1,25 +1,83 @@
-// main.cpp — Secuencial con overlay de FPS (tecla F) + barra inferior de FPS
+// main_par.cpp — Núcleo único del screensaver con overlay de FPS (tecla F) + barra inferior de FPS.
+// El backend de ejecución se elige con --backend=serial|omp|stdpar|pool (secuencial/main_sec.cpp
+// es este mismo archivo con serial por defecto).
 // Compilar (MSYS2/MinGW64):
-//   g++ -O2 -std=c++17 -Wall -Wextra -Wshadow main.cpp -o screensaver $(pkg-config --cflags --libs sdl2 SDL2_ttf)
+//   g++ -O2 -std=c++17 -Wall -Wextra -Wshadow main_par.cpp -o screensaver $(pkg-config --cflags --libs sdl2 SDL2_ttf) -fopenmp
+// Con backend stdpar (std::execution, en GCC vía TBB): agregar -DSCREENSAVER_STDPAR -ltbb
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <omp.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <cstdlib>
+#include <cstdio>
+#include <cctype>
 #include <ctime>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#ifdef SCREENSAVER_STDPAR
+#include <execution>
+#endif
+#include <fstream>
+#include <iomanip>
 
 // ---------------- Utilidades ----------------
-static float frand(float a, float b) { return a + (b - a) * (float(rand()) / float(RAND_MAX)); }
 static float clampf(float x, float a, float b) { return std::max(a, std::min(b, x)); }
 static bool  startsWith(const std::string& s, const std::string& pre){ return s.rfind(pre,0)==0; }
 static float toFloat(const std::string& s, float def){ try{ return std::stof(s);}catch(...){return def;} }
 static int   toInt  (const std::string& s, int def){ try{ return std::stoi(s);}catch(...){return def;} }
 
+// RNG por contador (SplitMix64): cada valor depende solo de (seed, flujo, índice),
+// así la inicialización se reparte entre hilos y da lo mismo con 1 o N hilos.
+static inline Uint64 splitmix64(Uint64 z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+enum : Uint64 { kRngMains = 1, kRngSats = 2 };
+
+struct CounterRng {
+    Uint64 key, ctr = 0;
+    CounterRng(Uint64 seed, Uint64 stream, Uint64 index)
+        : key(splitmix64(seed ^ splitmix64((stream << 48) ^ index))) {}
+    Uint32 next() { return Uint32(splitmix64(key + ctr++ * 0x9E3779B97F4A7C15ull) >> 32); }
+    float uniform(float a, float b) { return a + (b - a) * (float(next() >> 8) * (1.f / 16777216.f)); }
+};
+
+// Empaqueta un color en RGBA8888 (mismo layout que SDL_MapRGBA con ese formato)
+static inline Uint32 packRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    return (Uint32(r) << 24) | (Uint32(g) << 16) | (Uint32(b) << 8) | Uint32(a);
+}
+
 // Círculo relleno sin libs extra (SDL2)
 static void drawFilledCircle(SDL_Renderer* r, int cx, int cy, int radius) {
     for (int y = -radius; y <= radius; ++y) {
@@ -38,9 +96,56 @@ struct Body {
     float mass=1;
     SDL_Color color{255,255,255,255};
     bool is_main=false;       // principales (verde, rojo)
+    float sign=+1.f;          // principales: +1 atrae, -1 repele
     float eject_cooldown=0.f; // cuenta regresiva tras “salir disparado”
 };
 
+// Qué se mide en --benchmark:
+//   SIM    -> solo step() (sin SDL)
+//   RASTER -> step() + raster por software a un buffer en memoria (sin SDL)
+//   FULL   -> pipeline completo con ventana, textura y SDL_RenderPresent
+enum class BenchMode { SIM, RASTER, FULL };
+
+// Cómo se dibujan los satélites:
+//   CIRCLES -> círculos opacos de satRadius (raster por tiles)
+//   DENSITY -> mapa de calor con la cantidad de satélites por píxel
+enum class RenderMode { CIRCLES, DENSITY };
+
+static const char* renderModeLabel(RenderMode m) {
+    return (m == RenderMode::DENSITY) ? "density" : "circles";
+}
+
+// Nivel SIMD del kernel de satélites (AUTO = detectar por CPUID al arrancar)
+enum class SimdLevel { SCALAR, SSE, AVX2, AVX512, AUTO };
+
+static const char* simdLabel(SimdLevel l) {
+    switch (l) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE:    return "sse";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default:                return "auto";
+    }
+}
+
+static constexpr int kMaxMains = 1024;
+
+// Backend de ejecución de los loops de satélites (mismo trabajo en todos)
+enum class Backend { SERIAL, OMP, STDPAR, POOL };
+
+static const char* backendLabel(Backend b) {
+    switch (b) {
+        case Backend::SERIAL: return "serial";
+        case Backend::OMP:    return "omp";
+        case Backend::STDPAR: return "stdpar";
+        default:              return "pool";
+    }
+}
+
+#ifndef SCREENSAVER_DEFAULT_BACKEND
+#define SCREENSAVER_DEFAULT_BACKEND Backend::OMP
+#endif
+
 struct SimParams {
     int width=960, height=540;
     int N=10000;
@@ -48,7 +153,8 @@ struct SimParams {
     // Gravedad global (con signo por principal)
     float G=30.5f;
 
-    // Principales (A=verde, B=rojo)
+    // Principales (A=verde, B=rojo); se alternan A,B,A,B... hasta numMains
+    int numMains=4;
     float mainRadiusA=14.f, mainRadiusB=14.f;
     float mainMassA=50000.f, mainMassB=1000000.f;
     float mainInitSpeed=300.f; // rapidez inicial
@@ -68,15 +174,257 @@ struct SimParams {
     float wallRestitution=0.95f;
     float softening=8.0f;
 
+    // Paso fijo: step() corre a simHz con hasta maxSubsteps por frame dibujado;
+    // el render interpola entre los dos últimos pasos
+    float simHz = 60.f;
+    int maxSubsteps = 8;
+    bool interpolate = true;
+
+    // Pipeline: la física del frame N+1 corre en otro hilo mientras se dibuja el N
+    bool pipeline = false;
+
+    // Semilla de la inicialización (0 = se toma del reloj al arrancar)
+    Uint64 seed = 0;
+
+    // Telemetría por fase: si no está vacío se escribe <base>.csv y <base>.json al salir
+    std::string telemetryOut;
+
+    // Grabación de frames (--record=salida.y4m, otra extensión = RGBA crudo); vacío = no graba
+    std::string recordOut;
+
+    // Checkpoint binario: se guarda al terminar la corrida / se carga en vez de initSim()
+    std::string saveCheckpoint, loadCheckpoint;
+
+    // Trayectorias: cada trajEvery pasos se graba el estado en trajOut (vacío = no graba);
+    // replay reproduce un archivo grabado en vez de simular
+    std::string trajOut, replay;
+    int trajEvery = 1;
+
     // Benchmark mode
     bool benchmark = false;
     int benchmarkFrames = 500;
+    bool benchJson = false; // además imprime una línea BENCH_JSON {...} para bench_runner
+    BenchMode benchMode = BenchMode::FULL; // SIM/RASTER no crean ventana ni renderer
+
+    // Render de satélites (--render=circles|density, tecla D); exposure escala el mapa de calor
+    RenderMode renderMode = RenderMode::CIRCLES;
+    float densityExposure = 1.f;
+
+    // Kernel de satélites (--simd=auto|scalar|sse|avx2|avx512)
+    SimdLevel simd = SimdLevel::AUTO;
+
+    // Backend de ejecución (--backend=serial|omp|stdpar|pool)
+    Backend backend = SCREENSAVER_DEFAULT_BACKEND;
+
+    // Auto-gravedad satélite-satélite (Barnes-Hut); theta = ángulo de apertura
+    bool selfGravity = false;
+    float theta = 0.5f;
+
+    // Colisiones satélite-satélite (grilla uniforme); 1 = elástica, 0 = plástica
+    bool satCollisions = false;
+    float satRestitution = 0.8f;
+
+    // Reordenar los satélites por código Morton cada K pasos (0 = nunca)
+    int reorderEvery = 0;
+
+    // Satélites compactos (--compact=16|32, 0 = SatArray en float); compactReport
+    // compara contra el camino en float al final del benchmark sin ventana
+    int compactBits = 0;
+    bool compactReport = false;
+};
+
+// Allocator alineado a línea de caché para los arreglos de satélites
+template <class T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t kAlign = 64;
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U>&) {}
+    T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(kAlign))); }
+    void deallocate(T* ptr, std::size_t) { ::operator delete(ptr, std::align_val_t(kAlign)); }
+    template <class U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+template <class T> using AlignedVec = std::vector<T, AlignedAllocator<T>>;
+
+// Satélites en formato SoA: el loop de step() solo lee/escribe lo que usa
+// (x, y, vx, vy, cooldown = 20 B/partícula). Radio y masa son iguales para
+// toda la población y se guardan una sola vez.
+struct SatArray {
+    AlignedVec<float>  x, y;
+    AlignedVec<float>  vx, vy;
+    AlignedVec<float>  cooldown; // cuenta regresiva tras “salir disparado”
+    AlignedVec<Uint32> color;    // RGBA8888 (ver packRGBA)
+    float radius = 4.f;
+    float mass   = 1.f;
+    Uint64 generation = 0;       // cambia cuando se regeneran o se permutan (ver trajAfterStep)
+
+    std::size_t size() const { return x.size(); }
+    void resize(std::size_t n) {
+        x.resize(n); y.resize(n); vx.resize(n); vy.resize(n);
+        cooldown.resize(n); color.resize(n);
+    }
+    void clear() {
+        x.clear(); y.clear(); vx.clear(); vy.clear();
+        cooldown.clear(); color.clear();
+    }
+};
+
+// Copia SoA de los principales para el loop de gravedad (se rearma cada step)
+struct MainsSoA {
+    AlignedVec<float> x, y;
+    AlignedVec<float> gm;   // sign*G*mass
+    int count = 0;
+};
+
+// Índice espacial de principales para la eyección: grilla gruesa donde cada
+// celda lista (en orden) los principales cuyo disco de contacto la toca.
+// Así cada satélite solo prueba los principales cercanos (casi siempre 0).
+struct MainIndex {
+    int gx = 1, gy = 1;
+    float inv = 1.f;              // 1/lado de celda
+    AlignedVec<int> count;        // principales por celda (para gathers SIMD)
+    std::vector<int> start;       // gx*gy+1 offsets en list
+    std::vector<int> list;        // índices en SimState::mains
+
+    int cellOf(float x, float y) const {
+        int cx = std::min(gx - 1, std::max(0, (int)(x * inv)));
+        int cy = std::min(gy - 1, std::max(0, (int)(y * inv)));
+        return cy * gx + cx;
+    }
+};
+
+// ---------------- Satélites compactos (--compact=16|32) ----------------
+// Alternativa a SatArray para N muy grande: x,y en punto fijo relativo a la
+// ventana (16 o 32 bits), vx,vy en half float, cooldown en un byte (255 =
+// ejectCooldownSec) y el color como índice de una paleta de 256 entradas.
+// 10 B/partícula con 16 bits y 14 con 32, contra 24 de SatArray. El kernel
+// decodifica a float en registros, corre la misma física y vuelve a codificar.
+
+// float <-> half (IEEE binary16), redondeo al par más cercano; sin F16C para no
+// depender de la CPU. Fuera de rango satura a ±inf (las velocidades se acotan antes).
+static inline Uint16 floatToHalf(float f) {
+    Uint32 u; std::memcpy(&u, &f, 4);
+    const Uint32 sign = u & 0x80000000u;
+    u ^= sign;
+    Uint32 h;
+    if (u >= 0x47800000u) {                       // >= 65536 o NaN
+        h = (u > 0x7F800000u) ? 0x7E00u : 0x7C00u;
+    } else if (u < 0x38800000u) {                 // subnormal en half: lo redondea la suma en float
+        const Uint32 magicBits = 0x3F000000u;     // 0.5f
+        float fu, magic;
+        std::memcpy(&fu, &u, 4); std::memcpy(&magic, &magicBits, 4);
+        fu += magic;
+        std::memcpy(&u, &fu, 4);
+        h = u - magicBits;
+    } else {
+        const Uint32 odd = (u >> 13) & 1u;        // desempate al par
+        u += 0xC8000FFFu + odd;                   // rebias del exponente (-112 << 23) + redondeo
+        h = u >> 13;
+    }
+    return Uint16(h | (sign >> 16));
+}
+static inline float halfToFloat(Uint16 h) {
+    Uint32 u = Uint32(h & 0x7FFFu) << 13;
+    const Uint32 exp = u & 0x0F800000u;
+    u += 0x38000000u;                             // rebias del exponente (+112 << 23)
+    if (exp == 0x0F800000u) {
+        u += 0x38000000u;                         // inf / NaN
+    } else if (exp == 0) {                        // subnormal: normalizar con una resta en float
+        const Uint32 magicBits = 0x38800000u;     // 2^-14
+        u += 0x00800000u;
+        float f, magic;
+        std::memcpy(&f, &u, 4); std::memcpy(&magic, &magicBits, 4);
+        f -= magic;
+        std::memcpy(&u, &f, 4);
+    }
+    u |= Uint32(h & 0x8000u) << 16;
+    float f; std::memcpy(&f, &u, 4);
+    return f;
+}
+
+static constexpr float kHalfMax = 65504.f;
+
+// Paleta 8x8x4 (r,g,b) sobre el rango de colores que genera initSim
+static inline Uint8 compactColorIndex(Uint8 r, Uint8 g, Uint8 b) {
+    const int ir = std::min(7, std::max(0, (r - 180) * 8 / 70));
+    const int ig = std::min(7, std::max(0, (g - 180) * 8 / 70));
+    const int ib = std::min(3, std::max(0, (b - 200) * 4 / 55));
+    return Uint8((ir << 5) | (ig << 2) | ib);
+}
+
+struct CompactSats {
+    int bits = 0;                    // 0 = apagado, 16 o 32 (ancho de x,y)
+    AlignedVec<Uint16> x16, y16;     // solo se usa el par del ancho elegido
+    AlignedVec<Uint32> x32, y32;
+    AlignedVec<Uint16> vx, vy;       // half float
+    AlignedVec<Uint8>  cooldown;     // cooldown * cdToQ
+    AlignedVec<Uint8>  color;        // índice en palette
+    Uint32 palette[256] = {};
+    float toX = 1.f, toY = 1.f, fromX = 1.f, fromY = 1.f;   // píxeles <-> punto fijo
+    float cdToQ = 0.f, cdFromQ = 0.f;
+
+    std::size_t size() const { return vx.size(); }
+    std::size_t bytesPerSat() const { return bits ? 2 * (bits / 8) + 2 * sizeof(Uint16) + 2 : 0; }
+
+    void cols(Uint16*& px, Uint16*& py) { px = x16.data(); py = y16.data(); }
+    void cols(Uint32*& px, Uint32*& py) { px = x32.data(); py = y32.data(); }
+    void cols(const Uint16*& px, const Uint16*& py) const { px = x16.data(); py = y16.data(); }
+    void cols(const Uint32*& px, const Uint32*& py) const { px = x32.data(); py = y32.data(); }
+
+    void resize(std::size_t n) {
+        if (bits == 16) { x16.resize(n); y16.resize(n); }
+        else            { x32.resize(n); y32.resize(n); }
+        vx.resize(n); vy.resize(n); cooldown.resize(n); color.resize(n);
+    }
+    void clear() {
+        x16.clear(); y16.clear(); x32.clear(); y32.clear();
+        vx.clear(); vy.clear(); cooldown.clear(); color.clear();
+    }
 };
 
+// Escalas de la ventana y del cooldown + paleta; no toca los arreglos
+static void compactSetup(CompactSats& c, int bits, const SimParams& p) {
+    c.bits = bits;
+    const float maxQ = (bits == 16) ? 65535.f : 4294967040.f;   // el mayor float <= 2^32-1
+    c.toX = maxQ / float(p.width);  c.fromX = float(p.width)  / maxQ;
+    c.toY = maxQ / float(p.height); c.fromY = float(p.height) / maxQ;
+    c.cdToQ   = (p.ejectCooldownSec > 0.f) ? 255.f / p.ejectCooldownSec : 0.f;
+    c.cdFromQ = p.ejectCooldownSec / 255.f;
+    for (int k = 0; k < 256; k++) {
+        const int ir = k >> 5, ig = (k >> 2) & 7, ib = k & 3;   // centro de cada celda
+        c.palette[k] = packRGBA(Uint8(180 + ir * 70 / 8 + 4), Uint8(180 + ig * 70 / 8 + 4),
+                                Uint8(200 + ib * 55 / 4 + 7), 255);
+    }
+}
+
+template <class PosT>
+static inline PosT compactQuant(float v, float limit, float to) {
+    return PosT(clampf(v, 0.f, limit) * to + 0.5f);
+}
+
+// Codifica un satélite completo (init, conversión desde SatArray)
+static inline void compactStore(CompactSats& c, int i, float x, float y, float vx, float vy, float cd,
+                                Uint8 colorIdx, const SimParams& p) {
+    if (c.bits == 16) {
+        c.x16[i] = compactQuant<Uint16>(x, float(p.width), c.toX);
+        c.y16[i] = compactQuant<Uint16>(y, float(p.height), c.toY);
+    } else {
+        c.x32[i] = compactQuant<Uint32>(x, float(p.width), c.toX);
+        c.y32[i] = compactQuant<Uint32>(y, float(p.height), c.toY);
+    }
+    c.vx[i] = floatToHalf(clampf(vx, -kHalfMax, kHalfMax));
+    c.vy[i] = floatToHalf(clampf(vy, -kHalfMax, kHalfMax));
+    c.cooldown[i] = Uint8(clampf(cd * c.cdToQ + 0.5f, 0.f, 255.f));
+    c.color[i] = colorIdx;
+}
+
 struct SimState {
-    Body mainA, mainB;
-    Body mainA2, mainB2;
-    std::vector<Body> sats;
+    std::vector<Body> mains;  // par = tipo A (verde), impar = tipo B (rojo)
+    SatArray sats;
+    CompactSats compact;      // con --compact reemplaza a sats (que queda vacío salvo radio/masa)
+    MainsSoA mainsSoA;        // derivados de 'mains', ver packMains()
+    MainIndex mainIndex;
 };
 
 
@@ -111,310 +459,1916 @@ static void resolveElasticCollision(Body& a, Body& b) {
 }
 
 // Rebotar contra paredes
+static inline void bounceWalls(float& x, float& y, float& vx, float& vy, float radius, const SimParams& p) {
+    if (x - radius < 0)        { x = radius;            vx = -vx * p.wallRestitution; }
+    if (x + radius > p.width)  { x = p.width - radius;  vx = -vx * p.wallRestitution; }
+    if (y - radius < 0)        { y = radius;            vy = -vy * p.wallRestitution; }
+    if (y + radius > p.height) { y = p.height - radius; vy = -vy * p.wallRestitution; }
+}
 static void bounceWalls(Body& b, const SimParams& p) {
-    if (b.x - b.radius < 0)        { b.x = b.radius;            b.vx = -b.vx * p.wallRestitution; }
-    if (b.x + b.radius > p.width)  { b.x = p.width - b.radius;  b.vx = -b.vx * p.wallRestitution; }
-    if (b.y - b.radius < 0)        { b.y = b.radius;            b.vy = -b.vy * p.wallRestitution; }
-    if (b.y + b.radius > p.height) { b.y = p.height - b.radius; b.vy = -b.vy * p.wallRestitution; }
-}
-
-// Gravedad con signo y rampa tras eyección
-static void applyGravityFromMains(Body& s, const Body& A, const Body& B, const Body& A2, const Body& B2, const SimParams& p, float dt) {
-    auto gravOne = [&](const Body& M, float sign, float factor){
-        float dx = M.x - s.x, dy = M.y - s.y;
-        float r2 = dx*dx + dy*dy + p.softening*p.softening;
-        float invr = 1.0f / std::sqrt(r2);
-        float invr3 = invr*invr*invr;
-        // sign=+1 atrae, sign=-1 repele
-        float ax = sign * factor * p.G * M.mass * dx * invr3;
-        float ay = sign * factor * p.G * M.mass * dy * invr3;
-        s.vx += ax * dt; s.vy += ay * dt;
-    };
+    bounceWalls(b.x, b.y, b.vx, b.vy, b.radius, p);
+}
 
+// Gravedad con signo y rampa tras eyección (satélite en (sx,sy), actualiza vx/vy)
+static inline void applyGravityFromMains(float sx, float sy, float cooldown, float& vx, float& vy,
+                                         const MainsSoA& M, const SimParams& p, float dt) {
     // Factor de gravedad durante cooldown: de ~35% → 100%
     float factor = 1.0f;
-    if (s.eject_cooldown > 0.f && p.ejectCooldownSec > 0.f) {
-        float t = 1.f - clampf(s.eject_cooldown / p.ejectCooldownSec, 0.f, 1.f); // 0→1
+    if (cooldown > 0.f && p.ejectCooldownSec > 0.f) {
+        float t = 1.f - clampf(cooldown / p.ejectCooldownSec, 0.f, 1.f); // 0→1
         factor = p.postEjectGravityFactor + (1.f - p.postEjectGravityFactor) * t;
     }
 
-    gravOne(A, p.mainSignA, factor);
-    gravOne(B, p.mainSignB, factor);
-    gravOne(A2, p.mainSignA, factor);
-    gravOne(B2, p.mainSignB, factor);
+    // gm = sign*G*mass: sign=+1 atrae, sign=-1 repele
+    const float soft2 = p.softening * p.softening;
+    const float* mx = M.x.data(); const float* my = M.y.data(); const float* gm = M.gm.data();
+    float ax = 0.f, ay = 0.f;
+    #pragma omp simd reduction(+:ax,ay)
+    for (int k = 0; k < M.count; k++) {
+        float dx = mx[k] - sx, dy = my[k] - sy;
+        float invr = 1.0f / std::sqrt(dx*dx + dy*dy + soft2);
+        float s = gm[k] * invr * invr * invr;
+        ax += s * dx; ay += s * dy;
+    }
+    vx += factor * ax * dt;
+    vy += factor * ay * dt;
 }
 
 // ¿Satélite toca un principal? -> “sale disparado”
-static void checkEject(Body& s, const Body& M, const SimParams& p) {
-    float dx = s.x - M.x, dy = s.y - M.y;
+static inline void checkEject(float& x, float& y, float& vx, float& vy, float& cooldown, float radius,
+                              const Body& M, const SimParams& p) {
+    float dx = x - M.x, dy = y - M.y;
     float dist2 = dx*dx + dy*dy;
-    float minDist = s.radius + M.radius;
+    float minDist = radius + M.radius;
     if (dist2 <= minDist*minDist) {
         float d = std::sqrt(std::max(dist2, 1e-6f));
         float nx = dx / d, ny = dy / d;
-        s.vx = nx * p.ejectSpeed;
-        s.vy = ny * p.ejectSpeed;
-        s.eject_cooldown = p.ejectCooldownSec;
+        vx = nx * p.ejectSpeed;
+        vy = ny * p.ejectSpeed;
+        cooldown = p.ejectCooldownSec;
         // sacarlo justo fuera
         float push = (minDist - d) + 0.5f;
-        s.x += nx * push; s.y += ny * push;
+        x += nx * push; y += ny * push;
     }
 }
 
-// ---------------- Inicialización ----------------
-static void initSim(SimState& S, const SimParams& p) {
-    S.sats.clear();
-    // Principales
-    S.mainA.is_main = true;  S.mainA.radius = p.mainRadiusA; S.mainA.mass = p.mainMassA;
-    S.mainB.is_main = true;  S.mainB.radius = p.mainRadiusB; S.mainB.mass = p.mainMassB;
-
-    S.mainA.x = p.width*0.25f; S.mainA.y = p.height*0.5f;
-    S.mainB.x = p.width*0.66f; S.mainB.y = p.height*0.5f;
+// Prueba de eyección solo contra los principales de la celda del satélite
+static inline void checkEjectNearby(float& x, float& y, float& vx, float& vy, float& cooldown, float radius,
+                                    const SimState& S, const SimParams& p) {
+    const MainIndex& I = S.mainIndex;
+    const int c = I.cellOf(x, y);
+    for (int k = I.start[c]; k < I.start[c + 1]; k++)
+        checkEject(x, y, vx, vy, cooldown, radius, S.mains[I.list[k]], p);
+}
 
-    S.mainA.vx = frand(-p.mainInitSpeed, p.mainInitSpeed);
-    S.mainA.vy = frand(-p.mainInitSpeed, p.mainInitSpeed);
-    S.mainB.vx = frand(-p.mainInitSpeed, p.mainInitSpeed);
-    S.mainB.vy = frand(-p.mainInitSpeed, p.mainInitSpeed);
+// Rearma la copia SoA y el índice de eyección a partir de S.mains
+static void packMains(SimState& S, const SimParams& p) {
+    const int m = (int)S.mains.size();
+    MainsSoA& M = S.mainsSoA;
+    M.count = m;
+    M.x.resize(m); M.y.resize(m); M.gm.resize(m);
+    float maxR = 0.f;
+    for (int k = 0; k < m; k++) {
+        const Body& b = S.mains[k];
+        M.x[k] = b.x; M.y[k] = b.y;
+        M.gm[k] = b.sign * p.G * b.mass;
+        maxR = std::max(maxR, b.radius);
+    }
 
-    S.mainA.color = SDL_Color{  0,255,  0,255}; // verde (atrae)
-    S.mainB.color = SDL_Color{255, 64, 64,255}; // rojo (repele)
+    MainIndex& I = S.mainIndex;
+    const float satR = S.sats.radius;
+    const float cell = std::max(32.f, 2.f * (maxR + satR + 1.f));
+    I.inv = 1.f / cell;
+    I.gx = std::max(1, (int)std::ceil(p.width  / cell));
+    I.gy = std::max(1, (int)std::ceil(p.height / cell));
+    const int nCells = I.gx * I.gy;
+    I.count.assign(nCells, 0);
+    I.start.assign(nCells + 1, 0);
 
-    S.mainA2 = S.mainA;
-    S.mainB2 = S.mainB; 
+    // Dos pasadas (conteo + llenado) recorriendo los principales en orden
+    auto forCells = [&](const Body& b, auto&& fn) {
+        float reach = b.radius + satR + 1.f;
+        int x0 = std::max(0, (int)((b.x - reach) * I.inv)), x1 = std::min(I.gx - 1, (int)((b.x + reach) * I.inv));
+        int y0 = std::max(0, (int)((b.y - reach) * I.inv)), y1 = std::min(I.gy - 1, (int)((b.y + reach) * I.inv));
+        for (int cy = y0; cy <= y1; cy++)
+            for (int cx = x0; cx <= x1; cx++) fn(cy * I.gx + cx);
+    };
+    for (int k = 0; k < m; k++) forCells(S.mains[k], [&](int c){ I.count[c]++; });
+    for (int c = 0; c < nCells; c++) I.start[c + 1] = I.start[c] + I.count[c];
+    I.list.resize(I.start[nCells]);
+    std::vector<int> cursor(I.start.begin(), I.start.end() - 1);
+    for (int k = 0; k < m; k++) forCells(S.mains[k], [&](int c){ I.list[cursor[c]++] = k; });
+}
 
-    S.mainB2.x = p.width*0.33f; S.mainA2.y = p.height*0.25f;
-    S.mainA2.x = p.width*0.66f; S.mainB2.y = p.height*0.75f;
+// ---------------- Backends de ejecución ----------------
+// parallelFor(b, n, grain, fn) llama fn(begin, end) sobre [0, n) en bloques de 'grain'
+// elementos. Los cuatro backends reparten exactamente los mismos bloques:
+//   serial : un loop normal (main también fija 1 hilo de OpenMP para el resto)
+//   omp    : omp parallel for schedule(runtime)
+//   stdpar : std::for_each(std::execution::par_unseq) sobre los índices de bloque
+//   pool   : pool propio de std::thread que reparte bloques con un contador atómico
+// parallelRegion(b, fn) es la versión SPMD: fn(team) corre una vez por hilo y las
+// fases se separan con teamBarrier(team), sin volver a crear/despertar el equipo.
+// Barnes-Hut, el radix sort y el raster siguen usando OpenMP directamente.
 
-    S.mainA2.color = SDL_Color{  0,255,  0,255};     // verde
-    S.mainB2.color = SDL_Color{255, 64, 64,255};   // rojo
+// Pausa de espera activa (no suelta el núcleo)
+static inline void cpuRelax() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
 
-    // Satélites
-    S.sats.resize(p.N);
-    for (int i=0;i<p.N;++i){
-        Body b;
-        b.radius = p.satRadius; b.mass = p.satMass;
-        float t = frand(0.25f, 0.75f);
-        b.x = S.mainA.x * (1-t) + S.mainB.x * t + frand(-40,40);
-        b.y = S.mainA.y + frand(-80,80);
-        b.vx = frand(-p.maxInitSpeed, p.maxInitSpeed)*0.15f;
-        b.vy = frand(-p.maxInitSpeed, p.maxInitSpeed)*0.15f;
-        b.color = SDL_Color{
-            Uint8(180+std::rand()%70),
-            Uint8(180+std::rand()%70),
-            Uint8(200+std::rand()%55),
-            255
-        };
-        S.sats[i] = b;
+// Espera activa acotada: 'spin' pausas y después yield (el llamador decide si duerme)
+template <class Pred>
+static bool spinUntil(const Pred& ready, int spin) {
+    for (int i = 0; i < spin; i++) {
+        if (ready()) return true;
+        cpuRelax();
     }
+    return ready();
 }
 
-// ---------------- Texto (SDL_ttf + fallback) ----------------
-static TTF_Font* gFont = nullptr;
-static void drawBlocksText(SDL_Renderer* r, int x, int y, SDL_Color col, const std::string& s) {
-    SDL_SetRenderDrawColor(r, col.r, col.g, col.b, col.a);
-    int w = 6, h = 10, pad=2;
-    SDL_Rect rect{ x, y, w, h };
-    for (size_t i=0;i<s.size();++i) {
-        rect.x = x + int(i)*(w+pad);
-        SDL_RenderFillRect(r, &rect);
+// Pool de hilos persistente; el hilo que llama a region() es el hilo 0 del equipo.
+// Entre regiones los workers esperan activamente un rato (las fases de un frame
+// llegan a microsegundos unas de otras) y recién después duermen en la condvar;
+// OMP_WAIT_POLICY=passive los manda a dormir enseguida, =active alarga la espera.
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake;
+    const std::function<void(int)>* job = nullptr;  // fn(tid)
+    std::atomic<Uint64> generation{0};
+    std::atomic<int> sleepers{0};      // workers dormidos en 'wake'
+    std::atomic<int> running{0};       // workers todavía dentro de la región actual
+    std::atomic<bool> quit{false};
+    std::atomic<int> next{0};          // contador de bloques de parallelFor
+    std::atomic<int> barCount{0};      // barrera centralizada: llegadas y generación
+    std::atomic<Uint64> barGen{0};
+    int spin = 1 << 14;
+
+    int size() const { return (int)workers.size() + 1; }
+
+    void start(int nThreads) {
+        if (const char* w = std::getenv("OMP_WAIT_POLICY")) {
+            std::string s = w;
+            for (char& c : s) c = (char)std::tolower((unsigned char)c);
+            if (s == "passive") spin = 0;
+            else if (s == "active") spin = 1 << 20;
+        }
+        // con más hilos que núcleos la espera activa le roba tiempo al que trabaja
+        const unsigned hw = std::thread::hardware_concurrency();
+        if (hw > 0 && (unsigned)nThreads > hw) spin = std::min(spin, 64);
+        for (int t = 1; t < nThreads; t++) workers.emplace_back([this, t]{ workerLoop(t); });
     }
-}
-static void drawText(SDL_Renderer* r, int x, int y, SDL_Color col, const std::string& s) {
-    if (gFont) {
-        SDL_Surface* surf = TTF_RenderUTF8_Blended(gFont, s.c_str(), col);
-        if (surf) {
-            SDL_Texture* tex = SDL_CreateTextureFromSurface(r, surf);
-            SDL_FreeSurface(surf);
-            if (tex) {
-                SDL_Rect dst{ x, y, 0, 0 };
-                SDL_QueryTexture(tex, nullptr, nullptr, &dst.w, &dst.h);
-                SDL_RenderCopy(r, tex, nullptr, &dst);
-                SDL_DestroyTexture(tex);
-                return;
+
+    void workerLoop(int tid) {
+        Uint64 seen = 0;
+        for (;;) {
+            auto ready = [&]{ return generation.load(std::memory_order_acquire) != seen || quit.load(std::memory_order_acquire); };
+            if (!spinUntil(ready, spin)) {
+                std::unique_lock<std::mutex> lk(m);
+                sleepers.fetch_add(1);
+                wake.wait(lk, ready);
+                sleepers.fetch_sub(1);
             }
+            if (quit.load(std::memory_order_acquire)) return;
+            seen = generation.load(std::memory_order_acquire);
+            (*job)(tid);
+            running.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // Ejecuta fn(tid) en todos los hilos del pool y vuelve cuando terminaron todos
+    void region(const std::function<void(int)>& fn) {
+        // la región anterior ya terminó (region espera a running == 0), así que nadie lee job
+        job = &fn;
+        running.store(size() - 1, std::memory_order_relaxed);
+        generation.fetch_add(1);                 // seq_cst: emparejado con sleepers (sin despertares perdidos)
+        if (sleepers.load() > 0) {
+            { std::lock_guard<std::mutex> lk(m); }
+            wake.notify_all();
+        }
+        fn(0);
+        auto finished = [&]{ return running.load(std::memory_order_acquire) == 0; };
+        while (!spinUntil(finished, 256)) std::this_thread::yield();
+    }
+
+    // Barrera entre fases de una región (la llaman todos los hilos del equipo)
+    void barrier() {
+        const int n = size();
+        if (n == 1) return;
+        const Uint64 g = barGen.load(std::memory_order_acquire);
+        if (barCount.fetch_add(1, std::memory_order_acq_rel) == n - 1) {
+            barCount.store(0, std::memory_order_relaxed);
+            barGen.fetch_add(1, std::memory_order_release);
+        } else {
+            auto passed = [&]{ return barGen.load(std::memory_order_acquire) != g; };
+            while (!spinUntil(passed, 256)) std::this_thread::yield();
+        }
+    }
+
+    // Reparto dinámico de 'count' bloques entre todos los hilos
+    void run(int count, const std::function<void(int)>& fn) {
+        next.store(0, std::memory_order_relaxed);
+        const std::function<void(int)> drain = [&](int) {
+            for (int b; (b = next.fetch_add(1, std::memory_order_relaxed)) < count; ) fn(b);
+        };
+        region(drain);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            quit.store(true);
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+        workers.clear();
+    }
+
+    ~ThreadPool() { if (!workers.empty()) stop(); }
+};
+static ThreadPool gPool;
+
+template <class F>
+static void parallelFor(Backend b, int n, int grain, const F& fn) {
+    const int nBlocks = (n + grain - 1) / grain;
+    auto block = [&](int k) { const int begin = k * grain; fn(begin, std::min(n, begin + grain)); };
+    switch (b) {
+        case Backend::SERIAL:
+            for (int k = 0; k < nBlocks; k++) block(k);
+            break;
+#ifdef SCREENSAVER_STDPAR
+        case Backend::STDPAR: {
+            static thread_local std::vector<int> ids;
+            if ((int)ids.size() != nBlocks) { ids.resize(nBlocks); std::iota(ids.begin(), ids.end(), 0); }
+            std::for_each(std::execution::par_unseq, ids.begin(), ids.end(), block);
+            break;
+        }
+#endif
+        case Backend::POOL: {
+            const std::function<void(int)> job(block);
+            gPool.run(nBlocks, job);
+            break;
         }
+        default:
+            // schedule(runtime): por defecto static (ver main), OMP_SCHEDULE lo cambia
+            #pragma omp parallel for schedule(runtime)
+            for (int k = 0; k < nBlocks; k++) block(k);
+            break;
     }
-    drawBlocksText(r, x, y, col, s);
 }
 
-// ---------------- Barra inferior de FPS (abajo) ----------------
-static void renderFPSBottomBar(SDL_Renderer* renderer, const std::vector<float>& fpsHist, int W, int H) {
-    const int barH = 56; // alto de la barra
-    SDL_Rect bar{0, H - barH, W, barH};
+// Equipo de una parallelRegion: hilo actual, tamaño y backend (para la barrera)
+struct Team {
+    Backend b;
+    int tid, nth;
+};
 
-    // Fondo semitransparente
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
-    SDL_RenderFillRect(renderer, &bar);
+// Corre fn(team) una vez por hilo. stdpar no tiene regiones SPMD: usa un equipo de OpenMP
+template <class F>
+static void parallelRegion(Backend b, const F& fn) {
+    switch (b) {
+        case Backend::SERIAL:
+            fn(Team{b, 0, 1});
+            break;
+        case Backend::POOL: {
+            const int nth = gPool.size();
+            const std::function<void(int)> job([&](int tid) { fn(Team{b, tid, nth}); });
+            gPool.region(job);
+            break;
+        }
+        default:
+            #pragma omp parallel
+            fn(Team{Backend::OMP, omp_get_thread_num(), omp_get_num_threads()});
+            break;
+    }
+}
 
-    // Borde superior
-    SDL_SetRenderDrawColor(renderer, 220, 220, 220, 220);
-    SDL_RenderDrawLine(renderer, 0, H - barH, W, H - barH);
+static inline void teamBarrier(const Team& t) {
+    if (t.nth == 1) return;
+    if (t.b == Backend::POOL) {
+        gPool.barrier();
+    } else {
+        #pragma omp barrier
+    }
+}
 
-    int x = 12;
-    int y = H - barH + 10;
+// Bloques [k0, k1) que le tocan al hilo t en un reparto estático contiguo
+static inline void teamBlocks(const Team& t, int nBlocks, int& k0, int& k1) {
+    k0 = (int)((long long)nBlocks * t.tid / t.nth);
+    k1 = (int)((long long)nBlocks * (t.tid + 1) / t.nth);
+}
 
-    // Construimos la cadena "FPS: v1 v2 ... v10" (de viejo → nuevo)
-    std::string s = "FPS: ";
-    for (size_t i = 0; i < fpsHist.size(); ++i) {
-        if (i) s += ' ';
-        s += std::to_string((int)std::round(fpsHist[i]));
+// parallelFor dentro de una región, sin barrera final. Con omp respeta schedule(runtime);
+// en el resto el reparto es el estático de teamBlocks
+template <class F>
+static void teamFor(const Team& t, int n, int grain, const F& fn) {
+    const int nBlocks = (n + grain - 1) / grain;
+    auto block = [&](int k) { const int begin = k * grain; fn(begin, std::min(n, begin + grain)); };
+    if (t.b == Backend::OMP) {
+        #pragma omp for schedule(runtime) nowait
+        for (int k = 0; k < nBlocks; k++) block(k);
+    } else {
+        int k0, k1;
+        teamBlocks(t, nBlocks, k0, k1);
+        for (int k = k0; k < k1; k++) block(k);
     }
-    drawText(renderer, x, y, SDL_Color{200,200,255,255}, s);
+}
 
-    // Indicamos cuál es el más reciente
-    if (!fpsHist.empty()) {
-        int latest = (int)std::round(fpsHist.back());
-        drawText(renderer, x, y + 22, SDL_Color{220,220,220,255}, std::string("Actual: ") + std::to_string(latest) + " FPS");
+// Valida el backend pedido y prepara sus hilos (OMP_NUM_THREADS manda en todos)
+static Backend resolveBackend(Backend b) {
+#ifndef SCREENSAVER_STDPAR
+    if (b == Backend::STDPAR) {
+        std::cerr << "[warn] --backend=stdpar requiere compilar con -DSCREENSAVER_STDPAR, usando omp\n";
+        b = Backend::OMP;
     }
+#endif
+    if (b == Backend::SERIAL) omp_set_num_threads(1);
+    if (b == Backend::POOL) gPool.start(omp_get_max_threads());
+    return b;
 }
 
-// ---------------- Escena principal ----------------
-static void renderSim(SDL_Renderer* r, const SimState& S, const SimParams& p, const std::vector<float>& fpsHist) {
-    SDL_SetRenderDrawColor(r, 10, 14, 20, 255);
-    SDL_RenderClear(r);
+// ---------------- Inicialización ----------------
+static void initSim(SimState& S, const SimParams& p) {
+    S.sats.clear();
+    S.sats.generation++;
+    // Principales: alternan tipo A (verde) y tipo B (rojo). Los 4 primeros
+    // conservan las posiciones clásicas; el resto se reparte al azar.
+    const int nm = std::max(0, p.numMains);
+    S.mains.assign(nm, Body{});
+    for (int k = 0; k < nm; k++) {
+        Body& M = S.mains[k];
+        const bool typeA = (k % 2 == 0);
+        M.is_main = true;
+        M.radius = typeA ? p.mainRadiusA : p.mainRadiusB;
+        M.mass   = typeA ? p.mainMassA   : p.mainMassB;
+        M.sign   = typeA ? p.mainSignA   : p.mainSignB;
+        M.color  = typeA ? SDL_Color{  0,255,  0,255}   // verde (atrae)
+                         : SDL_Color{255, 64, 64,255};  // rojo (repele)
+        CounterRng rng(p.seed, kRngMains, Uint64(k));
+        M.vx = rng.uniform(-p.mainInitSpeed, p.mainInitSpeed);
+        M.vy = rng.uniform(-p.mainInitSpeed, p.mainInitSpeed);
+        switch (k) {
+            case 0: M.x = p.width*0.25f; M.y = p.height*0.5f;  break;
+            case 1: M.x = p.width*0.66f; M.y = p.height*0.5f;  break;
+            case 2: M.x = p.width*0.66f; M.y = p.height*0.25f; M.vx = S.mains[0].vx; M.vy = S.mains[0].vy; break;
+            case 3: M.x = p.width*0.33f; M.y = p.height*0.75f; M.vx = S.mains[1].vx; M.vy = S.mains[1].vy; break;
+            default:
+                M.x = rng.uniform(M.radius, p.width  - M.radius);
+                M.y = rng.uniform(M.radius, p.height - M.radius);
+                break;
+        }
+    }
+    // Franja inicial de satélites entre los dos primeros principales
+    const float ax = (nm > 0) ? S.mains[0].x : p.width*0.25f;
+    const float ay = (nm > 0) ? S.mains[0].y : p.height*0.5f;
+    const float bx = (nm > 1) ? S.mains[1].x : p.width*0.66f;
 
     // Satélites
-    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, p.width, p.height, 32, SDL_PIXELFORMAT_RGBA8888);
-    Uint32* pixels = (Uint32*)surface->pixels;
-
-    #pragma omp parallel for schedule(static)
-    for (int i = 0; i < (int)S.sats.size(); i++) {
-        const Body& b = S.sats[i];
-        int cx = (int)std::lround(b.x);
-        int cy = (int)std::lround(b.y);
-        int rad = (int)std::lround(b.radius);  // usa el radius definido en tu SimParams
-
-        Uint32 color = SDL_MapRGBA(surface->format, b.color.r, b.color.g, b.color.b, 255);
-
-        for (int dy = -rad; dy <= rad; dy++) {
-            for (int dx = -rad; dx <= rad; dx++) {
-                if (dx*dx + dy*dy <= rad*rad) {  // dentro del círculo
-                    int x = cx + dx;
-                    int y = cy + dy;
-                    if (x >= 0 && x < p.width && y >= 0 && y < p.height) {
-                        pixels[y * p.width + x] = color;
-                    }
-                }
-            }
+    // Satélites (con --compact se codifican directo, sin pasar por SatArray)
+    SatArray& sat = S.sats;
+    CompactSats& cs = S.compact;
+    sat.radius = p.satRadius; sat.mass = p.satMass;
+    cs.clear();
+    cs.bits = p.compactBits;
+    if (cs.bits) { compactSetup(cs, cs.bits, p); cs.resize(p.N); }
+    else sat.resize(p.N);
+    parallelFor(p.backend, p.N, 4096, [&](int begin, int end) {
+    for (int i=begin;i<end;++i){
+        CounterRng rng(p.seed, kRngSats, Uint64(i));
+        float t = rng.uniform(0.25f, 0.75f);
+        const float x = ax * (1-t) + bx * t + rng.uniform(-40,40);
+        const float y = ay + rng.uniform(-80,80);
+        const float vx = rng.uniform(-p.maxInitSpeed, p.maxInitSpeed)*0.15f;
+        const float vy = rng.uniform(-p.maxInitSpeed, p.maxInitSpeed)*0.15f;
+        Uint8 cr = Uint8(180+rng.next()%70);
+        Uint8 cg = Uint8(180+rng.next()%70);
+        Uint8 cb = Uint8(200+rng.next()%55);
+        if (cs.bits) {
+            compactStore(cs, i, x, y, vx, vy, 0.f, compactColorIndex(cr, cg, cb), p);
+            continue;
         }
+        sat.x[i] = x; sat.y[i] = y;
+        sat.vx[i] = vx; sat.vy[i] = vy;
+        sat.cooldown[i] = 0.f;
+        sat.color[i] = packRGBA(cr, cg, cb, 255);
     }
+    });
+}
 
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(r, surface);
-    SDL_FreeSurface(surface);
-    SDL_RenderCopy(r, tex, nullptr, nullptr);
-    SDL_DestroyTexture(tex);
+// ---------------- Checkpoint binario ----------------
+// Archivo versionado con los parámetros de la física, los principales y las
+// columnas SoA de los satélites, cada sección alineada a 64 bytes. Se carga con
+// mmap (MapViewOfFile en Windows): el header y los principales se leen directo
+// del mapeo y cada columna se copia en paralelo a su AlignedVec, así las páginas
+// quedan en la memoria del hilo que después las procesa. Las columnas van con el
+// layout de la máquina que lo escribió (se verifican endianness y tamaños).
+static constexpr char   kCheckpointMagic[8] = { 'S','S','C','K','P','T','\0','\0' };
+static constexpr Uint32 kCheckpointVersion  = 1;
+static constexpr Uint32 kCheckpointEndian   = 0x01020304u;
+enum { kCkX, kCkY, kCkVX, kCkVY, kCkCooldown, kCkColor, kCkColumns };
 
-    // Principales
-    SDL_SetRenderDrawColor(r, S.mainA.color.r, S.mainA.color.g, S.mainA.color.b, 255);
-    drawFilledCircle(r, (int)std::lround(S.mainA.x), (int)std::lround(S.mainA.y), (int)S.mainA.radius);
-    SDL_SetRenderDrawColor(r, S.mainB.color.r, S.mainB.color.g, S.mainB.color.b, 255);
-    drawFilledCircle(r, (int)std::lround(S.mainB.x), (int)std::lround(S.mainB.y), (int)S.mainB.radius);
-    SDL_SetRenderDrawColor(r, S.mainA2.color.r, S.mainA2.color.g, S.mainA2.color.b, 255);
-    drawFilledCircle(r, (int)std::lround(S.mainA2.x), (int)std::lround(S.mainA2.y), (int)S.mainA2.radius);
-    SDL_SetRenderDrawColor(r, S.mainB2.color.r, S.mainB2.color.g, S.mainB2.color.b, 255);
-    drawFilledCircle(r, (int)std::lround(S.mainB2.x), (int)std::lround(S.mainB2.y), (int)S.mainB2.radius);
+// Lo que define la dinámica y la inicialización (los flags de ejecución no van)
+struct CheckpointParams {
+    Sint32 width, height, N, numMains;
+    float G;
+    float mainRadiusA, mainRadiusB, mainMassA, mainMassB;
+    float mainInitSpeed, mainDamping, mainSignA, mainSignB;
+    float satRadius, satMass, maxInitSpeed, ejectSpeed, ejectCooldownSec, postEjectGravityFactor;
+    float wallRestitution, softening, simHz, theta, satRestitution;
+    Uint64 seed;
+    Uint8 selfGravity, satCollisions, pad[6];
+};
 
-    // Barra inferior con la lista de FPS
-    renderFPSBottomBar(r, fpsHist, p.width, p.height);
+// Principal serializado campo por campo (sin bytes de relleno indeterminados)
+struct CheckpointBody {
+    float x, y, vx, vy, radius, mass, sign, ejectCooldown;
+    Uint8 color[4];
+    Uint8 isMain, pad[3];
+};
+
+struct CheckpointHeader {
+    char   magic[8];
+    Uint32 version, endian;
+    Uint32 headerBytes, bodyBytes;   // sizeof() de los structs al escribir: detecta layouts distintos
+    Uint64 fileBytes;
+    Uint64 numMains, numSats;
+    Uint64 mainsOffset;
+    Uint64 satOffset[kCkColumns];
+    CheckpointParams params;
+};
+static_assert(std::is_trivially_copyable<CheckpointHeader>::value, "el header se escribe tal cual");
+
+static inline Uint64 alignUp64(Uint64 v) { return (v + 63) & ~Uint64(63); }
+
+// Archivo de solo lectura mapeado en memoria
+struct MappedFile {
+    const Uint8* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+};
+static MappedFile gCheckpoint;   // --load-checkpoint: queda mapeado para los reinicios (tecla R)
+
+static bool mapFile(MappedFile& f, const std::string& path) {
+#ifdef _WIN32
+    f.file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (f.file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(f.file, &sz) || sz.QuadPart == 0) { CloseHandle(f.file); f.file = INVALID_HANDLE_VALUE; return false; }
+    f.mapping = CreateFileMappingA(f.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!f.mapping) { CloseHandle(f.file); f.file = INVALID_HANDLE_VALUE; return false; }
+    f.data = static_cast<const Uint8*>(MapViewOfFile(f.mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!f.data) { CloseHandle(f.mapping); CloseHandle(f.file); f.mapping = nullptr; f.file = INVALID_HANDLE_VALUE; return false; }
+    f.size = (std::size_t)sz.QuadPart;
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+    void* m = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);   // el mapeo sigue válido sin el descriptor
+    if (m == MAP_FAILED) return false;
+    madvise(m, (std::size_t)st.st_size, MADV_WILLNEED);
+    f.data = static_cast<const Uint8*>(m);
+    f.size = (std::size_t)st.st_size;
+#endif
+    return true;
 }
 
-// ---------------- Overlay/Panel de FPS (tecla F) ----------------
-static void renderFPSOverlay(SDL_Renderer* renderer, const std::vector<float>& fpsLog, int W, int H) {
-    // Panel centrado con fondo semi-transparente
-    int margin = 40;
-    SDL_Rect panel{ margin, margin, W - 2*margin, H - 2*margin };
+static void unmapFile(MappedFile& f) {
+    if (!f.data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(f.data);
+    CloseHandle(f.mapping);
+    CloseHandle(f.file);
+    f.mapping = nullptr; f.file = INVALID_HANDLE_VALUE;
+#else
+    munmap(const_cast<Uint8*>(f.data), f.size);
+#endif
+    f.data = nullptr; f.size = 0;
+}
 
-    // Fondo translúcido
-    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(renderer, 18, 20, 26, 220);
-    SDL_RenderFillRect(renderer, &panel);
+static void writePadding(std::ofstream& out, Uint64 upTo) {
+    static const char zeros[64] = {};
+    const Uint64 pos = (Uint64)out.tellp();
+    if (upTo > pos) out.write(zeros, (std::streamsize)(upTo - pos));
+}
 
-    // Borde
-    SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255);
-    SDL_RenderDrawRect(renderer, &panel);
+static bool saveCheckpoint(const SimState& S, const SimParams& p, const std::string& path) {
+    const SatArray& sat = S.sats;
+    CheckpointHeader h{};
+    std::memcpy(h.magic, kCheckpointMagic, sizeof h.magic);
+    h.version = kCheckpointVersion; h.endian = kCheckpointEndian;
+    h.headerBytes = sizeof(CheckpointHeader); h.bodyBytes = sizeof(CheckpointBody);
+    h.numMains = S.mains.size(); h.numSats = sat.size();
 
-    int x = panel.x + 20;
-    int y = panel.y + 16;
+    CheckpointParams& c = h.params;
+    c.width = p.width; c.height = p.height; c.N = (Sint32)sat.size(); c.numMains = (Sint32)S.mains.size();
+    c.G = p.G;
+    c.mainRadiusA = p.mainRadiusA; c.mainRadiusB = p.mainRadiusB; c.mainMassA = p.mainMassA; c.mainMassB = p.mainMassB;
+    c.mainInitSpeed = p.mainInitSpeed; c.mainDamping = p.mainDamping; c.mainSignA = p.mainSignA; c.mainSignB = p.mainSignB;
+    c.satRadius = sat.radius; c.satMass = sat.mass; c.maxInitSpeed = p.maxInitSpeed; c.ejectSpeed = p.ejectSpeed;
+    c.ejectCooldownSec = p.ejectCooldownSec; c.postEjectGravityFactor = p.postEjectGravityFactor;
+    c.wallRestitution = p.wallRestitution; c.softening = p.softening; c.simHz = p.simHz;
+    c.theta = p.theta; c.satRestitution = p.satRestitution;
+    c.seed = p.seed;
+    c.selfGravity = p.selfGravity; c.satCollisions = p.satCollisions;
 
-    drawText(renderer, x, y, SDL_Color{160,210,255,255}, "PANEL DE FPS (F para cerrar)");
-    y += 26;
+    Uint64 off = alignUp64(sizeof(CheckpointHeader));
+    h.mainsOffset = off;
+    off = alignUp64(off + h.numMains * sizeof(CheckpointBody));
+    for (int k = 0; k < kCkColumns; k++) {
+        h.satOffset[k] = off;
+        off = alignUp64(off + h.numSats * 4);   // float y Uint32: 4 bytes
+    }
+    h.fileBytes = off;
 
-    // Estadísticos rápidos (sobre lo último que tengamos, hasta 300)
-    size_t take = std::min<size_t>(300, fpsLog.size());
-    float avg = 0.f, mn = 1e9f, mx = 0.f;
-    for (size_t i = fpsLog.size() - take; i < fpsLog.size(); ++i) {
-        float v = fpsLog[i];
-        avg += v; mn = std::min(mn, v); mx = std::max(mx, v);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) { std::cerr << "[warn] no se pudo escribir el checkpoint " << path << "\n"; return false; }
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    writePadding(out, h.mainsOffset);
+    std::vector<CheckpointBody> mains(h.numMains, CheckpointBody{});
+    for (std::size_t k = 0; k < mains.size(); k++) {
+        const Body& M = S.mains[k];
+        CheckpointBody& b = mains[k];
+        b.x = M.x; b.y = M.y; b.vx = M.vx; b.vy = M.vy;
+        b.radius = M.radius; b.mass = M.mass; b.sign = M.sign; b.ejectCooldown = M.eject_cooldown;
+        b.color[0] = M.color.r; b.color[1] = M.color.g; b.color[2] = M.color.b; b.color[3] = M.color.a;
+        b.isMain = M.is_main;
     }
-    if (take > 0) avg /= float(take); else { mn = 0; mx = 0; }
-    drawText(renderer, x, y, SDL_Color{220,220,220,255},
-        "muestras: " + std::to_string((int)take) +
-        "   avg: " + std::to_string((int)std::round(avg)) +
-        "   min: " + std::to_string((int)std::round(mn)) +
-        "   max: " + std::to_string((int)std::round(mx)));
-    y += 24;
+    out.write(reinterpret_cast<const char*>(mains.data()), (std::streamsize)(h.numMains * sizeof(CheckpointBody)));
+    const void* cols[kCkColumns] = { sat.x.data(), sat.y.data(), sat.vx.data(), sat.vy.data(),
+                                     sat.cooldown.data(), sat.color.data() };
+    for (int k = 0; k < kCkColumns; k++) {
+        writePadding(out, h.satOffset[k]);
+        out.write(static_cast<const char*>(cols[k]), (std::streamsize)(h.numSats * 4));
+    }
+    writePadding(out, h.fileBytes);
+    if (!out) { std::cerr << "[warn] error escribiendo el checkpoint " << path << "\n"; return false; }
+    std::cout << "[Checkpoint] " << path << ": " << h.numSats << " satélites, " << h.numMains
+              << " principales, " << (h.fileBytes >> 20) << " MB\n";
+    return true;
+}
 
-    // Lista grande en columnas
-    int usableH = panel.h - (y - panel.y) - 16;
-    int rowH = 18;
-    int rows = std::max(1, usableH / rowH);
-    int cols = 4; // cuatro columnas
-    int colW = (panel.w - 40) / cols;
+// Valida el archivo mapeado; devuelve el header o nullptr (con el motivo en stderr)
+static const CheckpointHeader* checkpointHeader(const MappedFile& f, const std::string& path) {
+    auto fail = [&](const char* why) -> const CheckpointHeader* {
+        std::cerr << "Checkpoint " << path << " inválido: " << why << "\n";
+        return nullptr;
+    };
+    if (f.size < sizeof(CheckpointHeader)) return fail("archivo demasiado corto");
+    const CheckpointHeader* h = reinterpret_cast<const CheckpointHeader*>(f.data);
+    if (std::memcmp(h->magic, kCheckpointMagic, sizeof h->magic) != 0) return fail("no es un checkpoint");
+    if (h->version != kCheckpointVersion) return fail("versión no soportada");
+    if (h->endian != kCheckpointEndian || h->headerBytes != sizeof(CheckpointHeader) || h->bodyBytes != sizeof(CheckpointBody))
+        return fail("escrito en una máquina o compilación con otro layout");
+    if (h->fileBytes > f.size) return fail("archivo truncado");
+    if (h->numMains > (Uint64)kMaxMains || h->numSats > (Uint64)INT32_MAX) return fail("tamaños fuera de rango");
+    // Offset acotado y alineado antes de sumar (un offset corrupto no debe desbordar la suma)
+    if (h->mainsOffset > h->fileBytes || h->mainsOffset % alignof(CheckpointBody) != 0 ||
+        h->numMains * sizeof(CheckpointBody) > h->fileBytes - h->mainsOffset)
+        return fail("sección de principales fuera del archivo");
+    for (int k = 0; k < kCkColumns; k++)
+        if (h->satOffset[k] > h->fileBytes || h->satOffset[k] % 64 != 0 || h->numSats * 4 > h->fileBytes - h->satOffset[k])
+            return fail("columna de satélites fuera del archivo");
+    return h;
+}
 
-    size_t maxItems = (size_t)(rows * cols);
-    size_t count = std::min(maxItems, take);
+// Mapea --load-checkpoint y pasa sus parámetros a P (antes de crear la ventana)
+static bool openCheckpoint(SimParams& P) {
+    if (!mapFile(gCheckpoint, P.loadCheckpoint)) {
+        std::cerr << "No se pudo abrir el checkpoint " << P.loadCheckpoint << "\n";
+        return false;
+    }
+    const CheckpointHeader* h = checkpointHeader(gCheckpoint, P.loadCheckpoint);
+    if (!h) { unmapFile(gCheckpoint); return false; }
+    const CheckpointParams& c = h->params;
+    P.width = c.width; P.height = c.height; P.N = c.N; P.numMains = c.numMains;
+    P.G = c.G;
+    P.mainRadiusA = c.mainRadiusA; P.mainRadiusB = c.mainRadiusB; P.mainMassA = c.mainMassA; P.mainMassB = c.mainMassB;
+    P.mainInitSpeed = c.mainInitSpeed; P.mainDamping = c.mainDamping; P.mainSignA = c.mainSignA; P.mainSignB = c.mainSignB;
+    P.satRadius = c.satRadius; P.satMass = c.satMass; P.maxInitSpeed = c.maxInitSpeed; P.ejectSpeed = c.ejectSpeed;
+    P.ejectCooldownSec = c.ejectCooldownSec; P.postEjectGravityFactor = c.postEjectGravityFactor;
+    P.wallRestitution = c.wallRestitution; P.softening = c.softening; P.simHz = c.simHz;
+    P.theta = c.theta; P.satRestitution = c.satRestitution;
+    P.seed = c.seed;
+    P.selfGravity = c.selfGravity != 0; P.satCollisions = c.satCollisions != 0;
+    return true;
+}
 
-    // mostramos los últimos 'count' valores
-    size_t start = fpsLog.size() - count;
-    for (int c = 0; c < cols; ++c) {
-        for (int row = 0; row < rows; ++row) {
-            size_t idxInBlock = (size_t)c * (size_t)rows + (size_t)row;
-            size_t i = start + idxInBlock;
-            if (i >= fpsLog.size()) break;
-            int val = (int)std::round(fpsLog[i]);
-            int cx = x + c * colW;
-            int cy = y + row * rowH;
-            drawText(renderer, cx, cy, SDL_Color{240,240,240,255}, std::to_string(val));
-        }
+static void restoreCheckpoint(SimState& S, const SimParams& p, const MappedFile& f) {
+    const CheckpointHeader* h = reinterpret_cast<const CheckpointHeader*>(f.data);
+    const CheckpointBody* mains = reinterpret_cast<const CheckpointBody*>(f.data + h->mainsOffset);
+    S.mains.assign(h->numMains, Body{});
+    for (std::size_t k = 0; k < S.mains.size(); k++) {
+        const CheckpointBody& b = mains[k];
+        Body& M = S.mains[k];
+        M.x = b.x; M.y = b.y; M.vx = b.vx; M.vy = b.vy;
+        M.radius = b.radius; M.mass = b.mass; M.sign = b.sign; M.eject_cooldown = b.ejectCooldown;
+        M.color = SDL_Color{ b.color[0], b.color[1], b.color[2], b.color[3] };
+        M.is_main = b.isMain != 0;
     }
+
+    SatArray& sat = S.sats;
+    sat.radius = h->params.satRadius; sat.mass = h->params.satMass;
+    sat.generation++;
+    const int n = (int)h->numSats;
+    sat.resize(n);
+    void* cols[kCkColumns] = { sat.x.data(), sat.y.data(), sat.vx.data(), sat.vy.data(),
+                               sat.cooldown.data(), sat.color.data() };
+    parallelFor(p.backend, n, 65536, [&](int begin, int end) {
+        for (int k = 0; k < kCkColumns; k++)
+            std::memcpy(static_cast<Uint8*>(cols[k]) + (std::size_t)begin * 4,
+                        f.data + h->satOffset[k] + (std::size_t)begin * 4, (std::size_t)(end - begin) * 4);
+    });
 }
 
-// ---------------- Menú (escoger) ----------------
-enum class Mode { MENU, RUN, QUIT };
+// Estado inicial de la corrida (y de cada reinicio): el checkpoint si hay uno, si no initSim()
+static void startSim(SimState& S, const SimParams& p) {
+    if (gCheckpoint.data) restoreCheckpoint(S, p, gCheckpoint);
+    else initSim(S, p);
+}
 
-static const char* signLabel(float s){ return (s>=0.f) ? "ATRAE" : "REPELE"; }
+// ---------------- Grabador de trayectorias (--traj=) ----------------
+// Cada --trajEvery=K pasos se copia el estado de satélites y principales a uno de
+// dos snapshots y un hilo aparte lo codifica y lo escribe mientras la simulación
+// sigue. Si los dos snapshots están ocupados el frame se descarta y se cuenta:
+// el paso nunca espera al disco.
+// Formato columnar (x, y, vx, vy, cooldown): cada columna se cuantiza a enteros
+// (posición y velocidad en 1/16 px, cooldown en 1/255 de ejectCooldownSec), se le
+// resta el valor del mismo satélite en el frame escrito anterior (a x e y además
+// se les suma la velocidad anterior por el tiempo transcurrido, predicción que el
+// lector repite en enteros con 'advanceFx') y el residuo va en zigzag + varint
+// (1-2 bytes casi siempre). Los keyframes (delta contra 0, más la
+// columna de colores) van al empezar, cada kTrajKeyEvery frames y cuando los
+// satélites se regeneran o se reordenan. Al cerrar se agrega un índice con el
+// offset de cada frame para poder saltar a cualquiera.
+static constexpr char   kTrajMagic[8]      = { 'S','S','T','R','A','J','\0','\0' };
+static constexpr char   kTrajIndexMagic[8] = { 'S','S','T','R','J','I','D','X' };
+static constexpr Uint32 kTrajVersion    = 1;
+static constexpr Uint32 kTrajFrameMagic = 0x464A5254u;   // "TRJF"
+static constexpr int    kTrajKeyEvery   = 60;
+static constexpr float  kTrajPosScale   = 16.f;
+static constexpr Sint32 kTrajMaxQ       = (1 << 30) - 1;  // así los deltas entran en 32 bits
+enum { kTjX, kTjY, kTjVX, kTjVY, kTjCooldown, kTjColumns };
 
-static void drawMenu(SDL_Renderer* ren, const SimParams& P) {
-    SDL_SetRenderDrawColor(ren, 18, 20, 26, 255);
-    SDL_RenderClear(ren);
+struct TrajHeader {
+    char   magic[8];
+    Uint32 version, endian;
+    Uint32 headerBytes, frameHeaderBytes;
+    Sint32 width, height;
+    Uint32 everyK, keyEvery;
+    float  satRadius, simHz;
+    float  scale[kTjColumns];     // valor real = entero / scale
+    Uint64 seed;
+};
 
-    drawText(ren, 40,  60, SDL_Color{120,200,255,255}, "SCREENSAVER SECUENCIAL - MENU");
-    drawText(ren, 40, 110, SDL_Color{220,220,220,255}, "N (+/-50): " + std::to_string(P.N) + "  [N / Shift+N]");
-    drawText(ren, 40, 140, SDL_Color{220,220,220,255}, "G (+/-0.5): " + std::to_string(P.G) + "  [G / Shift+G]");
-    drawText(ren, 40, 170, SDL_Color{220,220,220,255}, "W/H (+/-32): " + std::to_string(P.width) + "x" + std::to_string(P.height));
-    drawText(ren, 40, 210, SDL_Color{220,220,220,255}, "Mass A/B (+/-50): " + std::to_string((int)P.mainMassA) + " / " + std::to_string((int)P.mainMassB) + "  [A,B]");
-    drawText(ren, 40, 240, SDL_Color{220,220,220,255}, "Radius A/B (+/-1): " + std::to_string((int)P.mainRadiusA) + " / " + std::to_string((int)P.mainRadiusB) + "  [R,T]");
-    drawText(ren, 40, 270, SDL_Color{220,220,220,255}, "Main init speed (+/-10): " + std::to_string((int)P.mainInitSpeed) + "  [M]");
-    drawText(ren, 40, 300, SDL_Color{220,220,220,255}, "Eject speed (+/-20): " + std::to_string((int)P.ejectSpeed) + "  [E]");
-    drawText(ren, 40, 330, SDL_Color{220,220,220,255}, std::string("Verde: ") + signLabel(P.mainSignA) + "  [Z]    Rojo: " + signLabel(P.mainSignB) + "  [X]");
-    drawText(ren, 40, 360, SDL_Color{200,200,200,255}, "ENTER: iniciar   |   ESC: salir");
+struct TrajMain { float x, y, vx, vy, radius; Uint32 color; };
 
-    SDL_RenderPresent(ren);
+// Bloque de un frame: header, numMains TrajMain, n colores (solo keyframes) y las columnas
+struct TrajFrameHeader {
+    Uint32 magic, key;            // key = 1: deltas contra 0 y con colores
+    Uint64 step;                  // paso de simulación (1 = después del primer step())
+    Uint32 n, numMains;
+    Sint32 advanceFx;             // tiempo desde el frame anterior en s*65536 (0 en keyframes)
+    Uint32 pad;
+    Uint64 colBytes[kTjColumns];  // bytes de cada columna codificada
+    Uint64 payloadBytes;          // todo lo que sigue a este header
+};
+
+struct TrajIndexEntry { Uint64 offset, step; Uint32 key, pad; };
+struct TrajFooter { char magic[8]; Uint64 indexOffset, frames; };
+
+static inline Uint32 zigzag(Sint32 d) { return (Uint32(d) << 1) ^ Uint32(d >> 31); }
+static inline Sint32 unzigzag(Uint32 z) { return Sint32(z >> 1) ^ -Sint32(z & 1); }
+
+// x e y predichas: valor anterior + v anterior * dt (posición y velocidad usan la misma escala)
+static inline Sint32 trajPredict(Sint32 prevPos, Sint32 prevVel, Sint32 advanceFx) {
+    return Sint32(Uint32(prevPos) + Uint32(Sint32((Sint64)prevVel * advanceFx >> 16)));
 }
 
-static Mode runMenu(SDL_Window*& win, SDL_Renderer*& ren, SimParams& P) {
-    while (true) {
-        SDL_Event e;
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) return Mode::QUIT;
-            if (e.type == SDL_KEYDOWN) {
-                bool shift = (SDL_GetModState() & KMOD_SHIFT) != 0;
-                switch (e.key.keysym.sym) {
-                    case SDLK_ESCAPE: return Mode::QUIT;
-                    case SDLK_RETURN: return Mode::RUN;
-                    case SDLK_n: P.N = std::max(0, P.N + (shift ? -50 : 50)); break;
-                    case SDLK_g: P.G = std::max(0.f, P.G + (shift ? -0.5f : 0.5f)); break;
+static inline Sint32 trajQuantize(float v, float scale) {
+    const float q = v * scale;
+    if (!(q > -kTrajMaxQ)) return -kTrajMaxQ;   // también NaN
+    if (q > kTrajMaxQ) return kTrajMaxQ;
+    return Sint32(q + (q >= 0.f ? 0.5f : -0.5f));
+}
+
+struct TrajSnapshot {
+    AlignedVec<float>  col[kTjColumns];
+    AlignedVec<Uint32> color;
+    std::vector<TrajMain> mains;
+    Uint64 step = 0, generation = 0;
+};
+
+struct TrajRecorder {
+    std::string path;
+    std::ofstream out;
+    int every = 1;
+    Uint64 steps = 0;
+    float scale[kTjColumns] = {};
+    TrajSnapshot snaps[2];
+    std::vector<int> freeSnaps;
+    std::deque<int> ready;
+    std::mutex m;
+    std::condition_variable cv, freed;
+    bool quit = false;
+    bool wait = false;             // sin loop de tiempo real (benchmarks): esperar en vez de descartar
+    long long written = 0, dropped = 0, keyframes = 0;
+    std::thread writer;
+    // Estado del escritor
+    Uint64 offset = 0, lastGeneration = 0, lastStep = 0;
+    float simHz = 60.f;
+    int sinceKey = 0;
+    std::vector<Sint32> prev[kTjColumns];
+    std::vector<Uint8> enc[kTjColumns];
+    std::vector<TrajIndexEntry> index;
+    bool failed = false;
+};
+static TrajRecorder gTraj;
+
+static void trajWrite(TrajRecorder& R, const void* data, std::size_t bytes) {
+    R.out.write(static_cast<const char*>(data), (std::streamsize)bytes);
+    R.offset += bytes;
+}
+
+static void trajEncodeFrame(TrajRecorder& R, const TrajSnapshot& T) {
+    const std::size_t n = T.col[0].size();
+    const bool key = R.index.empty() || T.generation != R.lastGeneration
+                  || R.prev[0].size() != n || R.sinceKey >= kTrajKeyEvery;
+    TrajFrameHeader fh{};
+    fh.magic = kTrajFrameMagic; fh.key = key; fh.step = T.step;
+    fh.n = (Uint32)n; fh.numMains = (Uint32)T.mains.size();
+    fh.advanceFx = key ? 0 : (Sint32)std::lround(double(T.step - R.lastStep) * 65536.0 / R.simHz);
+    fh.payloadBytes = T.mains.size() * sizeof(TrajMain) + (key ? n * sizeof(Uint32) : 0);
+    // En un keyframe se vacían todas las columnas antes de codificar: x e y leen
+    // prev[vx]/prev[vy], que con un N nuevo todavía tendrían el tamaño viejo
+    if (key)
+        for (int k = 0; k < kTjColumns; k++) R.prev[k].assign(n, 0);
+    for (int k = 0; k < kTjColumns; k++) {
+        R.enc[k].resize(n * 5);
+        Uint8* o = R.enc[k].data();
+        Sint32* prev = R.prev[k].data();
+        const Sint32* vel = (k == kTjX) ? R.prev[kTjVX].data() : (k == kTjY) ? R.prev[kTjVY].data() : nullptr;
+        const float* src = T.col[k].data();
+        const float sc = R.scale[k];
+        for (std::size_t i = 0; i < n; i++) {
+            const Sint32 q = trajQuantize(src[i], sc);
+            const Sint32 pred = vel ? trajPredict(prev[i], vel[i], fh.advanceFx) : prev[i];
+            Uint32 z = zigzag(Sint32(Uint32(q) - Uint32(pred)));
+            prev[i] = q;
+            while (z >= 0x80) { *o++ = Uint8(z | 0x80); z >>= 7; }
+            *o++ = Uint8(z);
+        }
+        fh.colBytes[k] = Uint64(o - R.enc[k].data());
+        fh.payloadBytes += fh.colBytes[k];
+    }
+    R.index.push_back(TrajIndexEntry{ R.offset, T.step, fh.key, 0 });
+    trajWrite(R, &fh, sizeof fh);
+    trajWrite(R, T.mains.data(), T.mains.size() * sizeof(TrajMain));
+    if (key) trajWrite(R, T.color.data(), n * sizeof(Uint32));
+    for (int k = 0; k < kTjColumns; k++) trajWrite(R, R.enc[k].data(), fh.colBytes[k]);
+    R.lastGeneration = T.generation;
+    R.lastStep = T.step;
+    R.sinceKey = key ? 1 : R.sinceKey + 1;
+    if (key) R.keyframes++;
+}
+
+static void trajWriter(TrajRecorder& R) {
+    for (;;) {
+        int b;
+        {
+            std::unique_lock<std::mutex> lk(R.m);
+            R.cv.wait(lk, [&] { return R.quit || !R.ready.empty(); });
+            if (R.ready.empty()) return;
+            b = R.ready.front();
+            R.ready.pop_front();
+        }
+        if (!R.failed) {
+            trajEncodeFrame(R, R.snaps[b]);
+            if (!R.out) { R.failed = true; std::cerr << "[warn] --traj: error escribiendo " << R.path << "\n"; }
+        }
+        {
+            std::lock_guard<std::mutex> lk(R.m);
+            R.freeSnaps.push_back(b);
+            if (R.failed) R.dropped++; else R.written++;
+        }
+        R.freed.notify_one();
+    }
+}
+
+static bool trajStart(TrajRecorder& R, const std::string& path, const SimParams& p) {
+    R.out.open(path, std::ios::binary);
+    if (!R.out) { std::cerr << "[warn] --traj: no se pudo abrir " << path << "\n"; return false; }
+    R.path = path;
+    R.every = std::max(1, p.trajEvery);
+    R.wait = p.benchmark;
+    R.simHz = p.simHz;
+    R.scale[kTjX] = R.scale[kTjY] = R.scale[kTjVX] = R.scale[kTjVY] = kTrajPosScale;
+    R.scale[kTjCooldown] = (p.ejectCooldownSec > 0.f) ? 255.f / p.ejectCooldownSec : 1.f;
+
+    TrajHeader h{};
+    std::memcpy(h.magic, kTrajMagic, sizeof h.magic);
+    h.version = kTrajVersion; h.endian = kCheckpointEndian;
+    h.headerBytes = sizeof(TrajHeader); h.frameHeaderBytes = sizeof(TrajFrameHeader);
+    h.width = p.width; h.height = p.height;
+    h.everyK = (Uint32)R.every; h.keyEvery = kTrajKeyEvery;
+    h.satRadius = p.satRadius; h.simHz = p.simHz;
+    for (int k = 0; k < kTjColumns; k++) h.scale[k] = R.scale[k];
+    h.seed = p.seed;
+    R.offset = 0;
+    trajWrite(R, &h, sizeof h);
+
+    R.steps = 0; R.sinceKey = 0;
+    R.index.clear();
+    R.freeSnaps = { 0, 1 };
+    R.ready.clear();
+    R.quit = R.failed = false;
+    R.written = R.dropped = R.keyframes = 0;
+    R.writer = std::thread(trajWriter, std::ref(R));
+    return true;
+}
+
+// Se llama después de cada step(): cada 'every' pasos copia el estado a un snapshot libre.
+// En la ventana, si los dos están ocupados el frame se descarta para no frenar el loop;
+// en los benchmarks (sin tiempo real) se espera al escritor y el archivo queda completo.
+static void trajAfterStep(TrajRecorder& R, const SimState& S, const SimParams& p) {
+    if (!R.writer.joinable()) return;
+    if (++R.steps % (Uint64)R.every != 0) return;
+    int b;
+    {
+        std::unique_lock<std::mutex> lk(R.m);
+        if (R.wait) R.freed.wait(lk, [&] { return !R.freeSnaps.empty(); });
+        if (R.freeSnaps.empty()) { R.dropped++; return; }
+        b = R.freeSnaps.back();
+        R.freeSnaps.pop_back();
+    }
+    TrajSnapshot& T = R.snaps[b];
+    const SatArray& sat = S.sats;
+    const int n = (int)sat.size();
+    const float* src[kTjColumns] = { sat.x.data(), sat.y.data(), sat.vx.data(), sat.vy.data(), sat.cooldown.data() };
+    for (int k = 0; k < kTjColumns; k++) T.col[k].resize(n);
+    T.color.resize(n);
+    parallelFor(p.backend, n, 65536, [&](int begin, int end) {
+        const std::size_t cnt = (std::size_t)(end - begin);
+        for (int k = 0; k < kTjColumns; k++) std::memcpy(T.col[k].data() + begin, src[k] + begin, cnt * sizeof(float));
+        std::memcpy(T.color.data() + begin, sat.color.data() + begin, cnt * sizeof(Uint32));
+    });
+    T.mains.resize(S.mains.size());
+    for (std::size_t k = 0; k < S.mains.size(); k++) {
+        const Body& M = S.mains[k];
+        T.mains[k] = TrajMain{ M.x, M.y, M.vx, M.vy, M.radius, packRGBA(M.color.r, M.color.g, M.color.b, 255) };
+    }
+    T.step = R.steps;
+    T.generation = sat.generation;
+    {
+        std::lock_guard<std::mutex> lk(R.m);
+        R.ready.push_back(b);
+    }
+    R.cv.notify_one();
+}
+
+// Termina de escribir lo encolado, agrega el índice de frames y cierra
+static void trajStop(TrajRecorder& R) {
+    if (!R.writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(R.m);
+        R.quit = true;
+    }
+    R.cv.notify_one();
+    R.writer.join();
+    TrajFooter ft{};
+    std::memcpy(ft.magic, kTrajIndexMagic, sizeof ft.magic);
+    ft.indexOffset = R.offset;
+    ft.frames = R.index.size();
+    trajWrite(R, R.index.data(), R.index.size() * sizeof(TrajIndexEntry));
+    trajWrite(R, &ft, sizeof ft);
+    R.out.close();
+    const std::size_t n = R.snaps[0].col[0].size();
+    const double perSat = (R.written > 0 && n > 0) ? double(R.offset) / double(R.written) / double(n) : 0.0;
+    std::cout << "[Traj] " << R.path << ": " << R.written << " frames (" << R.keyframes << " keyframes), "
+              << R.dropped << " descartados, " << (R.offset >> 20) << " MB, "
+              << std::setprecision(3) << perSat << " B/satélite/frame\n" << std::setprecision(6);
+    for (TrajSnapshot& T : R.snaps) { for (auto& c : T.col) { c.clear(); c.shrink_to_fit(); } T.color.clear(); T.color.shrink_to_fit(); }
+    for (int k = 0; k < kTjColumns; k++) { R.prev[k] = {}; R.enc[k] = {}; }
+}
+
+// ---------------- Texto (atlas de glifos + fallback) ----------------
+// Los glifos ASCII se rasterizan una sola vez con SDL_ttf en una textura blanca;
+// cada string se dibuja como un lote de quads (SDL_RenderGeometry) con el color
+// en los vértices, sin crear superficies ni texturas por llamada.
+static TTF_Font* gFont = nullptr;
+
+struct GlyphAtlas {
+    SDL_Texture* tex = nullptr;
+    int texW = 0, texH = 0;
+    SDL_Rect src[128] = {};        // rect del glifo en la textura (w == 0: no existe)
+    int advance[128] = {};
+    std::vector<SDL_Vertex> verts; // scratch del lote
+    std::vector<int> idx;
+};
+static GlyphAtlas gAtlas;
+
+static void buildGlyphAtlas(SDL_Renderer* r, TTF_Font* font) {
+    const int atlasW = 512, lineH = TTF_FontHeight(font);
+    const SDL_Color white{255,255,255,255};
+    SDL_Surface* glyphs[128] = {};
+
+    // Empaquetado por filas: primero se calcula el alto necesario
+    int px = 0, py = 0;
+    for (int c = 32; c < 127; c++) {
+        SDL_Surface* g = TTF_RenderGlyph_Blended(font, Uint16(c), white);
+        if (!g) continue;
+        if (px + g->w > atlasW) { px = 0; py += lineH; }
+        glyphs[c] = g;
+        gAtlas.src[c] = SDL_Rect{ px, py, g->w, g->h };
+        int minx, maxx, miny, maxy, adv;
+        gAtlas.advance[c] = (TTF_GlyphMetrics(font, Uint16(c), &minx, &maxx, &miny, &maxy, &adv) == 0) ? adv : g->w;
+        px += g->w + 1;
+    }
+    const int atlasH = py + lineH;
+
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlasW, atlasH, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (atlas) {
+        SDL_FillRect(atlas, nullptr, 0);
+        for (int c = 32; c < 127; c++) {
+            if (!glyphs[c]) continue;
+            SDL_SetSurfaceBlendMode(glyphs[c], SDL_BLENDMODE_NONE); // copia el alpha tal cual
+            SDL_Rect dst = gAtlas.src[c];
+            SDL_BlitSurface(glyphs[c], nullptr, atlas, &dst);
+        }
+        gAtlas.tex = SDL_CreateTextureFromSurface(r, atlas);
+        SDL_FreeSurface(atlas);
+    }
+    for (SDL_Surface* g : glyphs) if (g) SDL_FreeSurface(g);
+
+    if (!gAtlas.tex) { std::cerr << "[warn] atlas de glifos: " << SDL_GetError() << " (usando fallback de bloques)\n"; return; }
+    SDL_SetTextureBlendMode(gAtlas.tex, SDL_BLENDMODE_BLEND);
+    gAtlas.texW = atlasW; gAtlas.texH = atlasH;
+}
+
+static void destroyGlyphAtlas(GlyphAtlas& A) {
+    if (A.tex) SDL_DestroyTexture(A.tex);
+    A.tex = nullptr;
+}
+
+static void drawBlocksText(SDL_Renderer* r, int x, int y, SDL_Color col, const std::string& s) {
+    SDL_SetRenderDrawColor(r, col.r, col.g, col.b, col.a);
+    int w = 6, h = 10, pad=2;
+    SDL_Rect rect{ x, y, w, h };
+    for (size_t i=0;i<s.size();++i) {
+        rect.x = x + int(i)*(w+pad);
+        SDL_RenderFillRect(r, &rect);
+    }
+}
+static void drawText(SDL_Renderer* r, int x, int y, SDL_Color col, const std::string& s) {
+    if (!gAtlas.tex) { drawBlocksText(r, x, y, col, s); return; }
+
+    GlyphAtlas& A = gAtlas;
+    A.verts.clear(); A.idx.clear();
+    const float iw = 1.f / A.texW, ih = 1.f / A.texH;
+    float pen = float(x);
+    for (unsigned char ch : s) {
+        int c = (ch >= 32 && ch < 127) ? ch : '?';
+        const SDL_Rect& g = A.src[c];
+        if (g.w > 0) {
+            const int base = (int)A.verts.size();
+            const float x0 = pen, y0 = float(y), x1 = pen + g.w, y1 = float(y + g.h);
+            const float u0 = g.x * iw, v0 = g.y * ih, u1 = (g.x + g.w) * iw, v1 = (g.y + g.h) * ih;
+            A.verts.push_back(SDL_Vertex{ SDL_FPoint{x0, y0}, col, SDL_FPoint{u0, v0} });
+            A.verts.push_back(SDL_Vertex{ SDL_FPoint{x1, y0}, col, SDL_FPoint{u1, v0} });
+            A.verts.push_back(SDL_Vertex{ SDL_FPoint{x1, y1}, col, SDL_FPoint{u1, v1} });
+            A.verts.push_back(SDL_Vertex{ SDL_FPoint{x0, y1}, col, SDL_FPoint{u0, v1} });
+            const int quad[6] = { base, base+1, base+2, base, base+2, base+3 };
+            A.idx.insert(A.idx.end(), quad, quad + 6);
+        }
+        pen += float(A.advance[c]);
+    }
+    if (!A.idx.empty())
+        SDL_RenderGeometry(r, A.tex, A.verts.data(), (int)A.verts.size(), A.idx.data(), (int)A.idx.size());
+}
+
+// ---------------- Telemetría por fase ----------------
+// Cada frame se parte en fases; teleMark() suma el tiempo transcurrido desde la
+// marca anterior a la fase indicada. Las muestras van a un ring de frames fijo
+// (sin allocs en el loop). Los reportes de fin de corrida (teleStats) ordenan el
+// ring y dan percentiles exactos; el panel en vivo usa teleStatsLive(), que lee un
+// histograma por fase que teleEndFrame() mantiene sobre la misma ventana del ring.
+enum TelePhase { TP_EVENTS, TP_STEP, TP_REORDER, TP_RASTER, TP_UPLOAD, TP_RECORD, TP_OVERLAY, TP_PRESENT, TP_FRAME, TP_COUNT };
+static const char* kTeleNames[TP_COUNT] = { "events", "step", "reorder", "raster", "upload", "record", "overlay", "present", "frame" };
+static constexpr int kTeleCap = 4096;
+
+struct TeleSample { float ms[TP_COUNT]; };
+struct TeleStats  { float p50 = 0, p95 = 0, p99 = 0, max = 0, mean = 0; };
+
+// Histograma logarítmico: 32 bins por octava (~2% de ancho) entre 2^-10 ms (~1 us)
+// y 2^14 ms; el bin sale directo de los bits del float (exponente + 5 bits de mantisa)
+static constexpr int kTeleBinShift = 18;
+static constexpr Uint32 kTeleBinLo = (127u - 10u) << (23 - kTeleBinShift);
+static constexpr int kTeleBins = 24 << (23 - kTeleBinShift);
+
+static inline int teleBin(float ms) {
+    Uint32 u; std::memcpy(&u, &ms, 4);
+    if ((Sint32)u <= 0) return 0;                     // 0 o negativo
+    const Uint32 b = u >> kTeleBinShift;
+    return b <= kTeleBinLo ? 0 : (int)std::min<Uint32>(kTeleBins - 1, b - kTeleBinLo);
+}
+static inline float teleBinValue(int bin) {           // centro del bin (el 0 cuenta como 0)
+    if (bin == 0) return 0.f;
+    const Uint32 u = ((Uint32(bin) + kTeleBinLo) << kTeleBinShift) | (1u << (kTeleBinShift - 1));
+    float f; std::memcpy(&f, &u, 4);
+    return f;
+}
+
+struct TeleHist {
+    Uint32 count[kTeleBins] = {};
+    double sum = 0.0;
+};
+
+struct Telemetry {
+    std::vector<TeleSample> ring = std::vector<TeleSample>(kTeleCap);
+    long long frames = 0;
+    TeleSample cur{};
+    double tFrame = 0.0, tLast = 0.0;
+    std::vector<float> scratch;   // copia para ordenar (percentiles)
+    std::vector<TeleHist> hist = std::vector<TeleHist>(TP_COUNT);
+};
+static Telemetry gTele;
+
+static void teleBeginFrame(Telemetry& T) {
+    T.cur = TeleSample{};
+    T.tFrame = T.tLast = omp_get_wtime();
+}
+
+static inline void teleMark(Telemetry& T, TelePhase ph) {
+    const double now = omp_get_wtime();
+    T.cur.ms[ph] += float((now - T.tLast) * 1000.0);
+    T.tLast = now;
+}
+
+static void teleEndFrame(Telemetry& T) {
+    T.cur.ms[TP_FRAME] = float((omp_get_wtime() - T.tFrame) * 1000.0);
+    TeleSample& slot = T.ring[T.frames % kTeleCap];
+    for (int ph = 0; ph < TP_COUNT; ph++) {
+        TeleHist& H = T.hist[ph];
+        if (T.frames >= kTeleCap) {           // sale del ring el frame que se pisa
+            H.count[teleBin(slot.ms[ph])]--;
+            H.sum -= slot.ms[ph];
+        }
+        H.count[teleBin(T.cur.ms[ph])]++;
+        H.sum += T.cur.ms[ph];
+    }
+    slot = T.cur;
+    T.frames++;
+}
+
+// Percentiles aproximados (al ancho del bin) sin copiar ni ordenar: para el panel F
+static TeleStats teleStatsLive(const Telemetry& T, int ph) {
+    TeleStats st;
+    const int n = (int)std::min<long long>(T.frames, kTeleCap);
+    if (n == 0) return st;
+    const TeleHist& H = T.hist[ph];
+    const long long r50 = (long long)(0.50f * (n - 1) + 0.5f), r95 = (long long)(0.95f * (n - 1) + 0.5f);
+    const long long r99 = (long long)(0.99f * (n - 1) + 0.5f);
+    long long acc = 0;
+    bool got50 = false, got95 = false, got99 = false;
+    for (int b = 0; b < kTeleBins; b++) {
+        if (!H.count[b]) continue;
+        acc += H.count[b];
+        const float v = teleBinValue(b);
+        if (!got50 && acc > r50) { st.p50 = v; got50 = true; }
+        if (!got95 && acc > r95) { st.p95 = v; got95 = true; }
+        if (!got99 && acc > r99) { st.p99 = v; got99 = true; }
+        st.max = v;
+    }
+    st.mean = float(std::max(0.0, H.sum) / n);
+    return st;
+}
+
+static TeleStats teleStats(Telemetry& T, int ph) {
+    TeleStats st;
+    const int n = (int)std::min<long long>(T.frames, kTeleCap);
+    if (n == 0) return st;
+    T.scratch.resize(n);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) { T.scratch[i] = T.ring[i].ms[ph]; sum += T.scratch[i]; }
+    std::sort(T.scratch.begin(), T.scratch.end());
+    auto pct = [&](float q) { return T.scratch[std::min(n - 1, int(q * (n - 1) + 0.5f))]; };
+    st.p50 = pct(0.50f); st.p95 = pct(0.95f); st.p99 = pct(0.99f);
+    st.max = T.scratch[n - 1]; st.mean = float(sum / n);
+    return st;
+}
+
+// Frames guardados en el ring y FPS del frame 'back' frames atrás (0 = el último cerrado);
+// la barra y el panel de FPS salen de acá, sin historiales propios
+static int teleFrameCount(const Telemetry& T) { return (int)std::min<long long>(T.frames, kTeleCap); }
+static float teleFps(const Telemetry& T, int back) {
+    const float ms = T.ring[(T.frames - 1 - back) % kTeleCap].ms[TP_FRAME];
+    return (ms > 0.f) ? 1000.f / ms : 0.f;
+}
+
+// base.csv: una fila por frame del ring (orden cronológico); base.json: resumen
+static void teleWriteFiles(Telemetry& T, const std::string& base) {
+    const int n = (int)std::min<long long>(T.frames, kTeleCap);
+    const long long first = T.frames - n;
+
+    std::ofstream csv(base + ".csv");
+    if (!csv) { std::cerr << "[warn] no se pudo escribir " << base << ".csv\n"; return; }
+    csv << "frame";
+    for (int ph = 0; ph < TP_COUNT; ph++) csv << ',' << kTeleNames[ph] << "_ms";
+    csv << '\n' << std::fixed << std::setprecision(4);
+    for (long long f = first; f < T.frames; f++) {
+        const TeleSample& sm = T.ring[f % kTeleCap];
+        csv << f;
+        for (int ph = 0; ph < TP_COUNT; ph++) csv << ',' << sm.ms[ph];
+        csv << '\n';
+    }
+
+    std::ofstream js(base + ".json");
+    if (!js) { std::cerr << "[warn] no se pudo escribir " << base << ".json\n"; return; }
+    js << std::fixed << std::setprecision(4);
+    js << "{\n  \"frames\": " << T.frames << ",\n  \"samples\": " << n << ",\n  \"phases\": {\n";
+    for (int ph = 0; ph < TP_COUNT; ph++) {
+        TeleStats st = teleStats(T, ph);
+        js << "    \"" << kTeleNames[ph] << "\": { \"mean\": " << st.mean << ", \"p50\": " << st.p50
+           << ", \"p95\": " << st.p95 << ", \"p99\": " << st.p99 << ", \"max\": " << st.max << " }"
+           << (ph + 1 < TP_COUNT ? ",\n" : "\n");
+    }
+    js << "  }\n}\n";
+    std::cout << "[Telemetria] " << n << " frames en " << base << ".csv / " << base << ".json\n";
+}
+
+// Resumen de una línea por fase (benchmarks)
+static void telePrint(Telemetry& T) {
+    for (int ph = 0; ph < TP_COUNT; ph++) {
+        TeleStats st = teleStats(T, ph);
+        if (st.max <= 0.f) continue;
+        std::cout << "[Benchmark] " << std::left << std::setw(8) << kTeleNames[ph] << std::right
+                  << " p50: " << st.p50 << "  p95: " << st.p95 << "  p99: " << st.p99
+                  << "  max: " << st.max << " ms\n";
+    }
+}
+
+// ---------------- Barra inferior de FPS (abajo) ----------------
+static void renderFPSBottomBar(SDL_Renderer* renderer, const Telemetry& T, int W, int H) {
+    const int barH = 56; // alto de la barra
+    SDL_Rect bar{0, H - barH, W, barH};
+
+    // Fondo semitransparente
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 180);
+    SDL_RenderFillRect(renderer, &bar);
+
+    // Borde superior
+    SDL_SetRenderDrawColor(renderer, 220, 220, 220, 220);
+    SDL_RenderDrawLine(renderer, 0, H - barH, W, H - barH);
+
+    int x = 12;
+    int y = H - barH + 10;
+
+    // Construimos la cadena "FPS: v1 v2 ... v10" (de viejo → nuevo)
+    const int n = std::min(10, teleFrameCount(T));
+    std::string s = "FPS: ";
+    for (int i = n - 1; i >= 0; --i) {
+        if (i != n - 1) s += ' ';
+        s += std::to_string((int)std::round(teleFps(T, i)));
+    }
+    drawText(renderer, x, y, SDL_Color{200,200,255,255}, s);
+
+    // Indicamos cuál es el más reciente
+    if (n > 0) {
+        int latest = (int)std::round(teleFps(T, 0));
+        drawText(renderer, x, y + 22, SDL_Color{220,220,220,255}, std::string("Actual: ") + std::to_string(latest) + " FPS");
+    }
+}
+
+// ---------------- Vista de dibujo + interpolación ----------------
+// Lo que se dibuja en un frame: posiciones de satélites y principales, que
+// pueden ser las de SimState o las interpoladas entre dos pasos fijos.
+struct DrawView {
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const Uint32* color = nullptr;
+    int n = 0;
+    float radius = 1.f;
+    const std::vector<Body>* mains = nullptr;
+
+    // Con --compact x, y y color quedan nulos: el raster decodifica cada satélite al
+    // leerlo desde el punto fijo de qbits (16|32) y el índice de paleta, sin copias
+    // en float. Con interpolación pqx/pqy son las posiciones del paso anterior.
+    int qbits = 0;
+    const void* qx = nullptr;
+    const void* qy = nullptr;
+    const void* pqx = nullptr;
+    const void* pqy = nullptr;
+    float alpha = 1.f, fromX = 1.f, fromY = 1.f;
+    const Uint8* colorIdx = nullptr;
+    const Uint32* palette = nullptr;
+
+    float qload(const void* q, int i) const {
+        return (qbits == 16) ? float(static_cast<const Uint16*>(q)[i]) : float(static_cast<const Uint32*>(q)[i]);
+    }
+    void pos(int i, float& px, float& py) const {
+        if (!qbits) { px = x[i]; py = y[i]; return; }
+        px = qload(qx, i) * fromX;
+        py = qload(qy, i) * fromY;
+        if (pqx) {
+            const float ox = qload(pqx, i) * fromX, oy = qload(pqy, i) * fromY;
+            px = ox + alpha * (px - ox);
+            py = oy + alpha * (py - oy);
+        }
+    }
+    Uint32 colorAt(int i) const { return color ? color[i] : palette[colorIdx[i]]; }
+    std::size_t qbytes() const { return (std::size_t)n * (qbits / 8); }   // bytes de qx (o qy)
+};
+
+static DrawView viewOf(const SimState& S) {
+    DrawView v;
+    const CompactSats& c = S.compact;
+    if (c.bits) {
+        v.qbits = c.bits;
+        if (c.bits == 16) { v.qx = c.x16.data(); v.qy = c.y16.data(); }
+        else              { v.qx = c.x32.data(); v.qy = c.y32.data(); }
+        v.fromX = c.fromX; v.fromY = c.fromY;
+        v.colorIdx = c.color.data(); v.palette = c.palette;
+        v.n = (int)c.size();
+    } else {
+        v.x = S.sats.x.data(); v.y = S.sats.y.data(); v.color = S.sats.color.data();
+        v.n = (int)S.sats.size();
+    }
+    v.radius = S.sats.radius;
+    v.mains = &S.mains;
+    return v;
+}
+
+// Paso fijo con interpolación: 'prev' guarda las posiciones antes del último
+// step() y el render dibuja prev + alpha*(actual - prev). Con --compact 'prev' es
+// una copia del punto fijo y la mezcla la hace el raster al decodificar.
+struct Interpolator {
+    AlignedVec<float> prevX, prevY, drawX, drawY;
+    AlignedVec<Uint8> prevQX, prevQY;
+    std::vector<Body> prevMains, drawMains;
+
+    void snapshot(const DrawView& v) {
+        if (v.qbits) {
+            const Uint8* qx = static_cast<const Uint8*>(v.qx);
+            const Uint8* qy = static_cast<const Uint8*>(v.qy);
+            prevQX.assign(qx, qx + v.qbytes());
+            prevQY.assign(qy, qy + v.qbytes());
+            prevX.clear(); prevY.clear();
+        } else {
+            prevX.assign(v.x, v.x + v.n);
+            prevY.assign(v.y, v.y + v.n);
+            prevQX.clear(); prevQY.clear();
+        }
+        prevMains = *v.mains;
+    }
+    void snapshot(const SimState& S) { snapshot(viewOf(S)); }
+
+    DrawView view(const DrawView& cur, float alpha) {
+        DrawView v = cur;
+        const int n = v.n;
+        const std::vector<Body>& mains = *cur.mains;
+        const bool valid = cur.qbits ? prevQX.size() == cur.qbytes() : prevX.size() == (std::size_t)n;
+        if (!valid || prevMains.size() != mains.size()) return v; // sin snapshot válido
+        if (cur.qbits) {
+            v.pqx = prevQX.data(); v.pqy = prevQY.data();
+            v.alpha = alpha;
+        } else {
+            drawX.resize(n); drawY.resize(n);
+            #pragma omp parallel for simd schedule(static)
+            for (int i = 0; i < n; i++) {
+                drawX[i] = prevX[i] + alpha * (cur.x[i] - prevX[i]);
+                drawY[i] = prevY[i] + alpha * (cur.y[i] - prevY[i]);
+            }
+            v.x = drawX.data(); v.y = drawY.data();
+        }
+        drawMains = mains;
+        for (std::size_t k = 0; k < drawMains.size(); k++) {
+            drawMains[k].x = prevMains[k].x + alpha * (mains[k].x - prevMains[k].x);
+            drawMains[k].y = prevMains[k].y + alpha * (mains[k].y - prevMains[k].y);
+        }
+        v.mains = &drawMains;
+        return v;
+    }
+    DrawView view(const SimState& S, float alpha) { return view(viewOf(S), alpha); }
+};
+
+// ---------------- Raster por software ----------------
+// Raster por tiles: cada satélite se agrupa (binning) en los tiles de pantalla
+// que toca su círculo y cada tile lo pinta un solo hilo, en orden creciente de
+// índice. Así no hay escrituras concurrentes al mismo píxel, la imagen es la
+// misma que la secuencial con cualquier número de hilos, y los cúmulos densos
+// no provocan false sharing. Los tiles se reparten dinámicamente.
+// Con 'bg' cada hilo limpia su tile justo antes de dibujarlo: el fondo se pinta
+// dentro de la misma región (sin otra pasada ni otro fork/join) y con el tile en caché.
+static constexpr int kTileSize = 64;
+
+struct TileBins {
+    int tilesX = 0, tilesY = 0;
+    std::vector<Uint32> cursor;  // [hilo][tile]: conteo y luego posición de escritura
+    std::vector<Uint32> offset;  // inicio de cada tile en idx (tiles+1 entradas)
+    std::vector<Uint32> idx;     // índices de satélite agrupados por tile
+};
+static TileBins gBins;
+
+// Rango de tiles que cubre el círculo de un satélite; false si cae fuera de pantalla
+static inline bool satTileRange(float x, float y, int rad, const SimParams& p,
+                                int& tx0, int& tx1, int& ty0, int& ty1) {
+    int cx = (int)std::lround(x), cy = (int)std::lround(y);
+    int x0 = std::max(0, cx - rad), x1 = std::min(p.width  - 1, cx + rad);
+    int y0 = std::max(0, cy - rad), y1 = std::min(p.height - 1, cy + rad);
+    if (x0 > x1 || y0 > y1) return false;
+    tx0 = x0 / kTileSize; tx1 = x1 / kTileSize;
+    ty0 = y0 / kTileSize; ty1 = y1 / kTileSize;
+    return true;
+}
+
+// Sellos de círculo: como todos los satélites comparten radio, cada círculo se
+// dibuja como 2r+1 filas [cx-h, cx+h] con h = semiancho precalculado por fila
+// (los mismos píxeles que dx*dx + dy*dy <= r*r). Para radios chicos la tabla es
+// constexpr y el loop de filas queda desenrollado; el resto la arma en runtime.
+static constexpr int kMaxStampRadius = 8;
+
+// Semiancho de la fila dy: mayor d con d*d + dy*dy <= r*r
+static constexpr int circleHalfWidth(int r, int dy) {
+    int d = 0;
+    while ((d + 1) * (d + 1) + dy * dy <= r * r) d++;
+    return d;
+}
+
+template <int R>
+struct CircleSpans {
+    int half[2 * R + 1];
+    constexpr CircleSpans() : half() {
+        for (int dy = -R; dy <= R; dy++) half[dy + R] = circleHalfWidth(R, dy);
+    }
+};
+template <int R> static constexpr CircleSpans<R> kCircleSpans{};
+
+// Dibuja los satélites [k0, k1) de B.idx dentro del rectángulo del tile. R > 0: radio
+// fijo en compilación; R == 0: radio 'rad' con la tabla 'half' de runtime. Si el
+// círculo entra completo en el tile no se recorta nada (camino rápido).
+template <int R>
+static void stampTile(Uint32* pixels, int stride, const DrawView& v, const Uint32* idx, Uint32 k0, Uint32 k1,
+                      int X0, int X1, int Y0, int Y1, int rad, const int* half) {
+    const int r = (R > 0) ? R : rad;
+    const int* hw = (R > 0) ? kCircleSpans<R>.half : half;
+    for (Uint32 k = k0; k < k1; k++) {
+        const Uint32 i = idx[k];
+        float fx, fy;
+        v.pos((int)i, fx, fy);
+        const int cx = (int)std::lround(fx);
+        const int cy = (int)std::lround(fy);
+        const Uint32 color = v.colorAt((int)i);
+
+        if (r == 0) {                       // un solo píxel (ya está dentro del tile)
+            pixels[(std::ptrdiff_t)cy * stride + cx] = color;
+        } else if (cx - r >= X0 && cx + r < X1 && cy - r >= Y0 && cy + r < Y1) {
+            Uint32* row = pixels + (std::ptrdiff_t)(cy - r) * stride + cx;
+            for (int j = 0; j <= 2 * r; j++, row += stride) {
+                const int h = hw[j];
+                for (int dx = -h; dx <= h; dx++) row[dx] = color;
+            }
+        } else {
+            const int ya = std::max(Y0, cy - r), yb = std::min(Y1, cy + r + 1);
+            for (int y = ya; y < yb; y++) {
+                const int h = hw[y - cy + r];
+                const int xa = std::max(X0, cx - h), xb = std::min(X1, cx + h + 1);
+                Uint32* line = pixels + (std::ptrdiff_t)y * stride;
+                for (int x = xa; x < xb; x++) line[x] = color;
+            }
+        }
+    }
+}
+
+// Dibuja los satélites en un buffer RGBA8888 de p.width*p.height (no usa SDL);
+// si bg no es nulo, primero rellena cada tile con *bg
+static void rasterSats(Uint32* pixels, const DrawView& v, const SimParams& p, const Uint32* bg = nullptr) {
+    const int rad = (int)std::lround(v.radius);  // usa el radius definido en tu SimParams
+    const int n = v.n;
+
+    TileBins& B = gBins;
+    B.tilesX = (p.width  + kTileSize - 1) / kTileSize;
+    B.tilesY = (p.height + kTileSize - 1) / kTileSize;
+    const int nTiles = B.tilesX * B.tilesY;
+    const int maxThreads = omp_get_max_threads();
+    B.cursor.resize((std::size_t)maxThreads * nTiles);
+    B.offset.resize((std::size_t)nTiles + 1);
+
+    // Semianchos por fila para radios sin sello constexpr
+    std::vector<int> half(2 * rad + 1);
+    for (int dy = -rad; dy <= rad; dy++) half[dy + rad] = circleHalfWidth(rad, dy);
+    using StampFn = void (*)(Uint32*, int, const DrawView&, const Uint32*, Uint32, Uint32,
+                             int, int, int, int, int, const int*);
+    static constexpr StampFn kStamps[kMaxStampRadius + 1] = {
+        stampTile<0>, stampTile<1>, stampTile<2>, stampTile<3>, stampTile<4>,
+        stampTile<5>, stampTile<6>, stampTile<7>, stampTile<8>,
+    };
+    const StampFn stamp = kStamps[(rad >= 1 && rad <= kMaxStampRadius) ? rad : 0];
+
+    #pragma omp parallel
+    {
+        const int t   = omp_get_thread_num();
+        const int nth = omp_get_num_threads();
+        // Rango contiguo de satélites por hilo: concatenar hilo 0..nth-1 conserva el orden por índice
+        const int begin = (int)((long long)n * t / nth);
+        const int end   = (int)((long long)n * (t + 1) / nth);
+        Uint32* cur = &B.cursor[(std::size_t)t * nTiles];
+
+        // 1) Conteo por tile
+        std::fill(cur, cur + nTiles, 0u);
+        for (int i = begin; i < end; i++) {
+            int tx0, tx1, ty0, ty1;
+            float fx, fy;
+            v.pos(i, fx, fy);
+            if (!satTileRange(fx, fy, rad, p, tx0, tx1, ty0, ty1)) continue;
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++) cur[ty * B.tilesX + tx]++;
+        }
+        #pragma omp barrier
+
+        // 2) Prefijo (tile mayor, hilo menor): convierte conteos en posiciones de escritura
+        #pragma omp single
+        {
+            Uint32 acc = 0;
+            for (int tile = 0; tile < nTiles; tile++) {
+                B.offset[tile] = acc;
+                for (int h = 0; h < nth; h++) {
+                    Uint32& c = B.cursor[(std::size_t)h * nTiles + tile];
+                    Uint32 cnt = c;
+                    c = acc;
+                    acc += cnt;
+                }
+            }
+            B.offset[nTiles] = acc;
+            B.idx.resize(acc);
+        }
+
+        // 3) Scatter de índices
+        for (int i = begin; i < end; i++) {
+            int tx0, tx1, ty0, ty1;
+            float fx, fy;
+            v.pos(i, fx, fy);
+            if (!satTileRange(fx, fy, rad, p, tx0, tx1, ty0, ty1)) continue;
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++) B.idx[cur[ty * B.tilesX + tx]++] = (Uint32)i;
+        }
+        #pragma omp barrier
+
+        // 4) Cada tile lo dibuja un único hilo, recortado al rectángulo del tile
+        #pragma omp for schedule(dynamic, 1)
+        for (int tile = 0; tile < nTiles; tile++) {
+            const int X0 = (tile % B.tilesX) * kTileSize, Y0 = (tile / B.tilesX) * kTileSize;
+            const int X1 = std::min(p.width,  X0 + kTileSize);
+            const int Y1 = std::min(p.height, Y0 + kTileSize);
+            if (bg) {
+                const Uint32 c = *bg;
+                for (int y = Y0; y < Y1; y++) {
+                    Uint32* row = pixels + (std::size_t)y * p.width;
+                    #pragma omp simd
+                    for (int x = X0; x < X1; x++) row[x] = c;
+                }
+            }
+            stamp(pixels, p.width, v, B.idx.data(), B.offset[tile], B.offset[tile + 1],
+                  X0, X1, Y0, Y1, rad, half.data());
+        }
+    }
+}
+
+// ---------------- Modo densidad ----------------
+// Con millones de satélites los círculos opacos se tapan entre sí y casi todo el
+// raster es overdraw. En este modo cada satélite suma 1 al píxel de su centro en
+// un buffer de conteos propio de cada hilo (sin atómicos); luego los buffers se
+// suman repartiendo píxeles entre hilos y el total pasa por un mapeo logarítmico
+// (log(1+c) / log(1+max) * exposure) a una paleta de calor. El costo es N sumas
+// más unas pocas pasadas por píxel, sin importar el radio, y el conteo es entero:
+// la imagen es la misma con cualquier número de hilos.
+static constexpr int kDensityLut = 4096;  // conteos con índice de paleta precalculado
+
+struct DensityBuffers {
+    AlignedVec<Uint32> counts;   // [hilo][píxel]; la mezcla los deja en cero para el frame siguiente
+    AlignedVec<Uint32> total;    // suma de todos los hilos
+    Uint32 palette[256];         // [0] = fondo
+    Uint8  lut[kDensityLut];     // conteo -> índice de paleta
+};
+static DensityBuffers gDensity;
+
+// Rampa fondo -> azul -> cian -> amarillo -> blanco
+static void buildDensityPalette(Uint32* pal, Uint32 bg) {
+    const float stops[5][3] = {
+        { float(bg >> 24), float((bg >> 16) & 0xFF), float((bg >> 8) & 0xFF) },
+        { 30.f, 60.f, 170.f }, { 0.f, 200.f, 255.f }, { 255.f, 225.f, 70.f }, { 255.f, 255.f, 255.f },
+    };
+    pal[0] = bg;
+    for (int k = 1; k < 256; k++) {
+        const float t = float(k) / 255.f * 4.f;
+        const int s = std::min(3, int(t));
+        const float f = t - float(s);
+        auto mix = [&](int c) { return Uint8(stops[s][c] + f * (stops[s + 1][c] - stops[s][c]) + 0.5f); };
+        pal[k] = packRGBA(mix(0), mix(1), mix(2), 255);
+    }
+}
+
+static void rasterDensity(Uint32* pixels, const DrawView& v, const SimParams& p, Uint32 bg) {
+    DensityBuffers& D = gDensity;
+    const std::size_t np = (std::size_t)p.width * (std::size_t)p.height;
+    const int maxThreads = omp_get_max_threads();
+    if (D.counts.size() != np * maxThreads) D.counts.assign(np * maxThreads, 0u);
+    D.total.resize(np);
+    buildDensityPalette(D.palette, bg);
+
+    const int n = v.n;
+    const unsigned W = (unsigned)p.width, H = (unsigned)p.height;
+    Uint32 maxCount = 0;
+
+    #pragma omp parallel
+    {
+        const int t   = omp_get_thread_num();
+        const int nth = omp_get_num_threads();
+
+        // 1) Cada hilo acumula su rango de satélites en su propio buffer
+        Uint32* mine = &D.counts[(std::size_t)t * np];
+        const int begin = (int)((long long)n * t / nth);
+        const int end   = (int)((long long)n * (t + 1) / nth);
+        for (int i = begin; i < end; i++) {
+            float fx, fy;
+            v.pos(i, fx, fy);
+            const unsigned cx = (unsigned)(int)(fx + 0.5f);
+            const unsigned cy = (unsigned)(int)(fy + 0.5f);
+            if (cx < W && cy < H) mine[(std::size_t)cy * W + cx]++;
+        }
+        #pragma omp barrier
+
+        // 2) Suma de los buffers (y limpieza para el próximo frame) + máximo
+        #pragma omp for schedule(static) reduction(max:maxCount)
+        for (std::ptrdiff_t k = 0; k < (std::ptrdiff_t)np; k++) {
+            Uint32 c = 0;
+            for (int h = 0; h < nth; h++) {
+                Uint32& src = D.counts[(std::size_t)h * np + k];
+                c += src;
+                src = 0;
+            }
+            D.total[k] = c;
+            maxCount = std::max(maxCount, c);
+        }
+
+        // 3) Tabla conteo -> paleta para este máximo
+        const float scale = (maxCount > 0) ? 254.f * p.densityExposure / std::log1p(float(maxCount)) : 0.f;
+        #pragma omp single
+        {
+            D.lut[0] = 0;
+            for (int c = 1; c < kDensityLut; c++)
+                D.lut[c] = Uint8(1 + std::min(254, int(std::log1p(float(c)) * scale)));
+        }
+
+        // 4) Tone-map al framebuffer
+        #pragma omp for schedule(static)
+        for (std::ptrdiff_t k = 0; k < (std::ptrdiff_t)np; k++) {
+            const Uint32 c = D.total[k];
+            const int idx = (c < (Uint32)kDensityLut) ? D.lut[c]
+                          : 1 + std::min(254, int(std::log1p(float(c)) * scale));
+            pixels[k] = D.palette[idx];
+        }
+    }
+}
+
+// Capa de satélites según el modo de render; las dos rellenan el fondo con *bg
+static void rasterLayer(Uint32* pixels, const DrawView& v, const SimParams& p, const Uint32* bg) {
+    if (p.renderMode == RenderMode::DENSITY) rasterDensity(pixels, v, p, *bg);
+    else rasterSats(pixels, v, p, bg);
+}
+
+// ---------------- Framebuffer persistente ----------------
+// Textura STREAMING + buffer de píxeles que viven toda la corrida; solo se
+// recrean si cambia la resolución. Evita el malloc/page-faults y la creación
+// de textura por frame.
+struct Framebuffer {
+    SDL_Texture* tex = nullptr;
+    AlignedVec<Uint32> pixels;
+    int w = 0, h = 0;
+};
+static Framebuffer gFrame;
+
+static bool ensureFramebuffer(Framebuffer& fb, SDL_Renderer* r, int w, int h) {
+    if (fb.tex && fb.w == w && fb.h == h) return true;
+    if (fb.tex) SDL_DestroyTexture(fb.tex);
+    fb.tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+    if (!fb.tex) {
+        std::cerr << "SDL_CreateTexture error: " << SDL_GetError() << "\n";
+        fb.w = fb.h = 0;
+        return false;
+    }
+    SDL_SetTextureBlendMode(fb.tex, SDL_BLENDMODE_NONE); // el buffer ya trae el fondo
+    fb.pixels.assign((std::size_t)w * (std::size_t)h, 0u);
+    fb.w = w; fb.h = h;
+    return true;
+}
+
+static void destroyFramebuffer(Framebuffer& fb) {
+    if (fb.tex) SDL_DestroyTexture(fb.tex);
+    fb.tex = nullptr;
+    fb.pixels.clear(); fb.pixels.shrink_to_fit();
+    fb.w = fb.h = 0;
+}
+
+// Sube el buffer a la textura bloqueándola (copia por filas si el pitch del driver difiere)
+static void uploadFramebuffer(Framebuffer& fb) {
+    void* dst = nullptr;
+    int pitch = 0;
+    if (SDL_LockTexture(fb.tex, nullptr, &dst, &pitch) != 0) {
+        SDL_UpdateTexture(fb.tex, nullptr, fb.pixels.data(), fb.w * 4);
+        return;
+    }
+    const std::size_t rowBytes = (std::size_t)fb.w * 4;
+    if ((std::size_t)pitch == rowBytes) {
+        std::memcpy(dst, fb.pixels.data(), rowBytes * (std::size_t)fb.h);
+    } else {
+        for (int y = 0; y < fb.h; y++)
+            std::memcpy((Uint8*)dst + (std::size_t)y * pitch, &fb.pixels[(std::size_t)y * fb.w], rowBytes);
+    }
+    SDL_UnlockTexture(fb.tex);
+}
+
+// ---------------- Grabación asíncrona (--record=) ----------------
+// El hilo de render copia el frame terminado a un buffer libre y sigue; un hilo
+// aparte lo convierte y lo escribe. Los buffers se reciclan (cola acotada): si
+// el disco no da abasto no queda ninguno libre, el frame se descarta y se cuenta,
+// y el loop nunca espera al disco. Los principales se dibujan con SDL encima de
+// la textura, así que en la copia se vuelven a pintar por software.
+// Formato: .y4m = YUV4MPEG2 4:4:4 (BT.601), cualquier otra extensión = RGBA crudo.
+static constexpr int kRecordBuffers = 4;
+
+struct Recorder {
+    std::string path;
+    std::ofstream out;
+    bool y4m = false;
+    int w = 0, h = 0;
+    std::vector<AlignedVec<Uint32>> bufs;
+    std::vector<int> freeBufs;   // índices en bufs listos para copiar
+    std::deque<int> ready;       // frames copiados esperando al escritor (FIFO)
+    std::mutex m;
+    std::condition_variable cv;
+    bool quit = false;
+    long long written = 0, dropped = 0;
+    std::thread writer;
+};
+static Recorder gRec;
+
+static void fillCircleSoftware(Uint32* px, int W, int H, int cx, int cy, int r, Uint32 color) {
+    for (int y = std::max(0, cy - r); y <= std::min(H - 1, cy + r); y++) {
+        const int dy = y - cy;
+        const int dx = (int)std::floor(std::sqrt((double)(r * r - dy * dy)));
+        Uint32* row = px + (std::size_t)y * W;
+        for (int x = std::max(0, cx - dx); x <= std::min(W - 1, cx + dx); x++) row[x] = color;
+    }
+}
+
+static void recWriteFrame(Recorder& R, const Uint32* px, std::vector<Uint8>& tmp) {
+    const std::size_t np = (std::size_t)R.w * R.h;
+    tmp.resize(np * (R.y4m ? 3 : 4));
+    if (R.y4m) {
+        Uint8* Y = tmp.data(); Uint8* U = Y + np; Uint8* V = U + np;
+        for (std::size_t k = 0; k < np; k++) {
+            const int r = px[k] >> 24, g = (px[k] >> 16) & 0xFF, b = (px[k] >> 8) & 0xFF;
+            Y[k] = Uint8((( 66 * r + 129 * g +  25 * b + 128) >> 8) +  16);
+            U[k] = Uint8(((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+            V[k] = Uint8(((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+        }
+        R.out << "FRAME\n";
+    } else {
+        for (std::size_t k = 0; k < np; k++) {
+            tmp[4 * k + 0] = Uint8(px[k] >> 24); tmp[4 * k + 1] = Uint8(px[k] >> 16);
+            tmp[4 * k + 2] = Uint8(px[k] >> 8);  tmp[4 * k + 3] = Uint8(px[k]);
+        }
+    }
+    R.out.write(reinterpret_cast<const char*>(tmp.data()), (std::streamsize)tmp.size());
+}
+
+static void recWriter(Recorder& R) {
+    std::vector<Uint8> tmp;
+    bool failed = false;
+    for (;;) {
+        int b;
+        {
+            std::unique_lock<std::mutex> lk(R.m);
+            R.cv.wait(lk, [&] { return R.quit || !R.ready.empty(); });
+            if (R.ready.empty()) return;   // quit y cola vacía: ya se escribió todo
+            b = R.ready.front();
+            R.ready.pop_front();
+        }
+        if (!failed) {
+            recWriteFrame(R, R.bufs[b].data(), tmp);
+            if (!R.out) { failed = true; std::cerr << "[warn] --record: error escribiendo " << R.path << "\n"; }
+        }
+        std::lock_guard<std::mutex> lk(R.m);
+        R.freeBufs.push_back(b);
+        if (failed) R.dropped++; else R.written++;
+    }
+}
+
+static bool recStart(Recorder& R, const std::string& path, int w, int h, float fps) {
+    R.out.open(path, std::ios::binary);
+    if (!R.out) { std::cerr << "[warn] --record: no se pudo abrir " << path << "\n"; return false; }
+    R.path = path;
+    R.y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    R.w = w; R.h = h;
+    if (R.y4m) R.out << "YUV4MPEG2 W" << w << " H" << h << " F" << std::max(1, (int)std::lround(fps)) << ":1 Ip A1:1 C444\n";
+    R.bufs.assign(kRecordBuffers, AlignedVec<Uint32>((std::size_t)w * h));
+    R.freeBufs.clear(); R.ready.clear();
+    for (int b = 0; b < kRecordBuffers; b++) R.freeBufs.push_back(b);
+    R.quit = false;
+    R.written = R.dropped = 0;
+    R.writer = std::thread(recWriter, std::ref(R));
+    return true;
+}
+
+// Encola una copia del frame (w*h RGBA8888) con los principales encima; nunca bloquea por el disco
+static void recSubmit(Recorder& R, const Uint32* px, const std::vector<Body>* mains) {
+    if (!R.writer.joinable()) return;
+    int b;
+    {
+        std::lock_guard<std::mutex> lk(R.m);
+        if (R.freeBufs.empty()) { R.dropped++; return; }
+        b = R.freeBufs.back();
+        R.freeBufs.pop_back();
+    }
+    Uint32* dst = R.bufs[b].data();
+    std::memcpy(dst, px, (std::size_t)R.w * R.h * sizeof(Uint32));
+    if (mains) {
+        for (const Body& M : *mains)
+            fillCircleSoftware(dst, R.w, R.h, (int)std::lround(M.x), (int)std::lround(M.y), (int)M.radius,
+                               packRGBA(M.color.r, M.color.g, M.color.b, 255));
+    }
+    {
+        std::lock_guard<std::mutex> lk(R.m);
+        R.ready.push_back(b);
+    }
+    R.cv.notify_one();
+}
+
+// Espera a que se escriban los frames encolados y cierra el archivo
+static void recStop(Recorder& R) {
+    if (!R.writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lk(R.m);
+        R.quit = true;
+    }
+    R.cv.notify_one();
+    R.writer.join();
+    R.out.close();
+    std::cout << "[Record] " << R.path << ": " << R.written << " frames escritos, "
+              << R.dropped << " descartados\n";
+    R.bufs.clear(); R.bufs.shrink_to_fit();
+}
+
+// ---------------- Escena principal ----------------
+static void renderSim(SDL_Renderer* r, const DrawView& v, const SimParams& p, const Telemetry* fps) {
+    SDL_SetRenderDrawColor(r, 10, 14, 20, 255);
+    SDL_RenderClear(r);
+
+    // Satélites
+    if (ensureFramebuffer(gFrame, r, p.width, p.height)) {
+        const Uint32 bg = packRGBA(10, 14, 20, 255);
+        rasterLayer(gFrame.pixels.data(), v, p, &bg);
+        teleMark(gTele, TP_RASTER);
+        uploadFramebuffer(gFrame);
+        SDL_RenderCopy(r, gFrame.tex, nullptr, nullptr);
+        teleMark(gTele, TP_UPLOAD);
+        if (!p.recordOut.empty()) {
+            recSubmit(gRec, gFrame.pixels.data(), v.mains);
+            teleMark(gTele, TP_RECORD);
+        }
+    }
+
+    // Principales
+    for (const Body& M : *v.mains) {
+        SDL_SetRenderDrawColor(r, M.color.r, M.color.g, M.color.b, 255);
+        drawFilledCircle(r, (int)std::lround(M.x), (int)std::lround(M.y), (int)M.radius);
+    }
+    teleMark(gTele, TP_RASTER);
+
+    // Barra inferior con la lista de FPS
+    if (fps) renderFPSBottomBar(r, *fps, p.width, p.height);
+}
+
+// ---------------- Overlay/Panel de FPS (tecla F) ----------------
+static void renderFPSOverlay(SDL_Renderer* renderer, const Telemetry& T, int W, int H) {
+    // Panel centrado con fondo semi-transparente
+    int margin = 40;
+    SDL_Rect panel{ margin, margin, W - 2*margin, H - 2*margin };
+
+    // Fondo translúcido
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 18, 20, 26, 220);
+    SDL_RenderFillRect(renderer, &panel);
+
+    // Borde
+    SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255);
+    SDL_RenderDrawRect(renderer, &panel);
+
+    int x = panel.x + 20;
+    int y = panel.y + 16;
+
+    drawText(renderer, x, y, SDL_Color{160,210,255,255}, "PANEL DE FPS (F para cerrar)");
+    y += 26;
+
+    // Estadísticos rápidos (sobre lo último que tengamos, hasta 300)
+    size_t take = (size_t)std::min(300, teleFrameCount(T));
+    float avg = 0.f, mn = 1e9f, mx = 0.f;
+    for (size_t i = 0; i < take; ++i) {
+        float v = teleFps(T, (int)i);
+        avg += v; mn = std::min(mn, v); mx = std::max(mx, v);
+    }
+    if (take > 0) avg /= float(take); else { mn = 0; mx = 0; }
+    drawText(renderer, x, y, SDL_Color{220,220,220,255},
+        "muestras: " + std::to_string((int)take) +
+        "   avg: " + std::to_string((int)std::round(avg)) +
+        "   min: " + std::to_string((int)std::round(mn)) +
+        "   max: " + std::to_string((int)std::round(mx)));
+    y += 24;
+
+    // Tiempos por fase (ms) sobre el ring de telemetría
+    auto fmt = [](float v) { char b[16]; std::snprintf(b, sizeof b, "%7.2f", v); return std::string(b); };
+    drawText(renderer, x, y, SDL_Color{160,210,255,255}, "fase         p50      p95      p99      max   (ms)");
+    y += 20;
+    for (int ph = 0; ph < TP_COUNT; ph++) {
+        TeleStats st = teleStatsLive(gTele, ph);
+        std::string name = kTeleNames[ph];
+        name.resize(10, ' ');
+        drawText(renderer, x, y, SDL_Color{220,220,220,255},
+                 name + fmt(st.p50) + "  " + fmt(st.p95) + "  " + fmt(st.p99) + "  " + fmt(st.max));
+        y += 18;
+    }
+    y += 8;
+
+    // Lista grande en columnas
+    int usableH = panel.h - (y - panel.y) - 16;
+    int rowH = 18;
+    int rows = std::max(1, usableH / rowH);
+    int cols = 4; // cuatro columnas
+    int colW = (panel.w - 40) / cols;
+
+    size_t maxItems = (size_t)(rows * cols);
+    size_t count = std::min(maxItems, take);
+
+    // mostramos los últimos 'count' valores (de viejo → nuevo)
+    for (int c = 0; c < cols; ++c) {
+        for (int row = 0; row < rows; ++row) {
+            size_t idxInBlock = (size_t)c * (size_t)rows + (size_t)row;
+            if (idxInBlock >= count) break;
+            int val = (int)std::round(teleFps(T, (int)(count - 1 - idxInBlock)));
+            int cx = x + c * colW;
+            int cy = y + row * rowH;
+            drawText(renderer, cx, cy, SDL_Color{240,240,240,255}, std::to_string(val));
+        }
+    }
+}
+
+// ---------------- Menú (escoger) ----------------
+enum class Mode { MENU, RUN, QUIT };
+
+static const char* signLabel(float s){ return (s>=0.f) ? "ATRAE" : "REPELE"; }
+
+static void drawMenu(SDL_Renderer* ren, const SimParams& P) {
+    SDL_SetRenderDrawColor(ren, 18, 20, 26, 255);
+    SDL_RenderClear(ren);
+
+    drawText(ren, 40,  60, SDL_Color{120,200,255,255}, std::string("SCREENSAVER (") + backendLabel(P.backend) + ") - MENU");
+    drawText(ren, 40, 110, SDL_Color{220,220,220,255}, "N (+/-50): " + std::to_string(P.N) + "  [N / Shift+N]");
+    drawText(ren, 40, 140, SDL_Color{220,220,220,255}, "G (+/-0.5): " + std::to_string(P.G) + "  [G / Shift+G]");
+    drawText(ren, 40, 170, SDL_Color{220,220,220,255}, "W/H (+/-32): " + std::to_string(P.width) + "x" + std::to_string(P.height));
+    drawText(ren, 40, 210, SDL_Color{220,220,220,255}, "Mass A/B (+/-50): " + std::to_string((int)P.mainMassA) + " / " + std::to_string((int)P.mainMassB) + "  [A,B]");
+    drawText(ren, 40, 240, SDL_Color{220,220,220,255}, "Radius A/B (+/-1): " + std::to_string((int)P.mainRadiusA) + " / " + std::to_string((int)P.mainRadiusB) + "  [R,T]");
+    drawText(ren, 40, 270, SDL_Color{220,220,220,255}, "Main init speed (+/-10): " + std::to_string((int)P.mainInitSpeed) + "  [M]");
+    drawText(ren, 40, 300, SDL_Color{220,220,220,255}, "Eject speed (+/-20): " + std::to_string((int)P.ejectSpeed) + "  [E]");
+    drawText(ren, 40, 330, SDL_Color{220,220,220,255}, std::string("Verde: ") + signLabel(P.mainSignA) + "  [Z]    Rojo: " + signLabel(P.mainSignB) + "  [X]");
+    drawText(ren, 40, 360, SDL_Color{220,220,220,255}, std::string("Auto-gravedad (Barnes-Hut, theta ") + std::to_string(P.theta).substr(0,4) + "): " + (P.selfGravity ? "ON" : "OFF") + "  [S]");
+    drawText(ren, 40, 390, SDL_Color{220,220,220,255}, std::string("Colisiones entre satelites: ") + (P.satCollisions ? "ON" : "OFF") + "  [C]");
+    drawText(ren, 40, 420, SDL_Color{220,220,220,255}, "Principales (+/-1, alternan verde/rojo): " + std::to_string(P.numMains) + "  [K]");
+    drawText(ren, 40, 460, SDL_Color{200,200,200,255}, "ENTER: iniciar   |   ESC: salir");
+
+    SDL_RenderPresent(ren);
+}
+
+static Mode runMenu(SDL_Window*& win, SDL_Renderer*& ren, SimParams& P) {
+    while (true) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) return Mode::QUIT;
+            if (e.type == SDL_KEYDOWN) {
+                bool shift = (SDL_GetModState() & KMOD_SHIFT) != 0;
+                switch (e.key.keysym.sym) {
+                    case SDLK_ESCAPE: return Mode::QUIT;
+                    case SDLK_RETURN: return Mode::RUN;
+                    case SDLK_n: P.N = std::max(0, P.N + (shift ? -50 : 50)); break;
+                    case SDLK_g: P.G = std::max(0.f, P.G + (shift ? -0.5f : 0.5f)); break;
                     case SDLK_w: P.width  = std::max(640, P.width  + (shift ? -32 : 32)); break;
                     case SDLK_h: P.height = std::max(480, P.height + (shift ? -32 : 32)); break;
                     case SDLK_a: P.mainMassA = std::max(1.f, P.mainMassA + (shift ? -50.f : 50.f)); break;
@@ -425,47 +2379,1176 @@ static Mode runMenu(SDL_Window*& win, SDL_Renderer*& ren, SimParams& P) {
                     case SDLK_e: P.ejectSpeed   = std::max(0.f, P.ejectSpeed   + (shift ? -20.f : 20.f)); break;
                     case SDLK_z: P.mainSignA = (P.mainSignA >= 0.f) ? -1.f : +1.f; break; // toggle
                     case SDLK_x: P.mainSignB = (P.mainSignB >= 0.f) ? -1.f : +1.f; break; // toggle
+                    case SDLK_s: P.selfGravity = !P.selfGravity; break; // toggle
+                    case SDLK_c: P.satCollisions = !P.satCollisions; break; // toggle
+                    case SDLK_k: P.numMains = std::min(kMaxMains, std::max(0, P.numMains + (shift ? -1 : 1))); break;
                     default: break;
                 }
             }
         }
-        // Redimensionar ventana si cambió
-        int currentW, currentH;
-        SDL_GetRendererOutputSize(ren, &currentW, &currentH);
-        if (currentW != P.width || currentH != P.height) {
-            SDL_SetWindowSize(win, P.width, P.height);
-            SDL_RenderSetLogicalSize(ren, P.width, P.height);
+        // Redimensionar ventana si cambió
+        int currentW, currentH;
+        SDL_GetRendererOutputSize(ren, &currentW, &currentH);
+        if (currentW != P.width || currentH != P.height) {
+            SDL_SetWindowSize(win, P.width, P.height);
+            SDL_RenderSetLogicalSize(ren, P.width, P.height);
+        }
+        drawMenu(ren, P);
+        SDL_Delay(16);
+    }
+}
+
+// ---------------- CLI args ----------------
+static void parseArgs(int argc, char** argv, SimParams& P) {
+    for (int i=1;i<argc;++i){
+        std::string a(argv[i]);
+        if (startsWith(a,"--N="))              P.N = std::max(0, toInt(a.substr(4), P.N));
+        else if (startsWith(a,"--G="))         P.G = std::max(0.f, toFloat(a.substr(4), P.G));
+        else if (startsWith(a,"--width="))     P.width  = std::max(640, toInt(a.substr(8), P.width));
+        else if (startsWith(a,"--height="))    P.height = std::max(480, toInt(a.substr(9), P.height));
+        else if (startsWith(a,"--massA="))     P.mainMassA = std::max(1.f, toFloat(a.substr(8), P.mainMassA));
+        else if (startsWith(a,"--massB="))     P.mainMassB = std::max(1.f, toFloat(a.substr(8), P.mainMassB));
+        else if (startsWith(a,"--mains="))     P.numMains = std::min(kMaxMains, std::max(0, toInt(a.substr(8), P.numMains)));
+        else if (startsWith(a,"--radiusA="))   P.mainRadiusA = std::max(2.f, toFloat(a.substr(10), P.mainRadiusA));
+        else if (startsWith(a,"--radiusB="))   P.mainRadiusB = std::max(2.f, toFloat(a.substr(10), P.mainRadiusB));
+        else if (startsWith(a,"--mainInit="))  P.mainInitSpeed = std::max(0.f, toFloat(a.substr(11), P.mainInitSpeed));
+        else if (startsWith(a,"--eject="))     P.ejectSpeed = std::max(0.f, toFloat(a.substr(8), P.ejectSpeed));
+        else if (startsWith(a,"--satRadius=")) P.satRadius = std::max(0.25f, toFloat(a.substr(12), P.satRadius));   // < 0.5 -> un píxel
+        else if (startsWith(a,"--satMass="))   P.satMass   = std::max(0.1f, toFloat(a.substr(10), P.satMass));
+        else if (startsWith(a,"--signA="))     P.mainSignA = clampf(toFloat(a.substr(8), P.mainSignA), -1.f, +1.f);
+        else if (startsWith(a,"--signB="))     P.mainSignB = clampf(toFloat(a.substr(8), P.mainSignB), -1.f, +1.f);
+        else if (startsWith(a,"--simHz="))       P.simHz = clampf(toFloat(a.substr(8), P.simHz), 1.f, 10000.f);
+        else if (startsWith(a,"--maxSubsteps=")) P.maxSubsteps = std::max(1, toInt(a.substr(14), P.maxSubsteps));
+        else if (a == "--noInterp")  P.interpolate = false;
+        else if (a == "--pipeline")  P.pipeline = true;
+        else if (startsWith(a,"--seed=")) {
+            try { P.seed = std::stoull(a.substr(7)); } catch (...) { std::cerr << "[warn] --seed invalido: " << a << "\n"; }
+        }
+        else if (startsWith(a,"--telemetry=")) P.telemetryOut = a.substr(12);
+        else if (startsWith(a,"--record="))    P.recordOut = a.substr(9);
+        else if (startsWith(a,"--save-checkpoint=")) P.saveCheckpoint = a.substr(18);
+        else if (startsWith(a,"--load-checkpoint=")) P.loadCheckpoint = a.substr(18);
+        else if (startsWith(a,"--traj="))      P.trajOut = a.substr(7);
+        else if (startsWith(a,"--trajEvery=")) P.trajEvery = std::max(1, toInt(a.substr(12), P.trajEvery));
+        else if (startsWith(a,"--replay="))    P.replay = a.substr(9);
+        else if (a == "--benchmark")  P.benchmark = true;
+        else if (a == "--bench-json") P.benchJson = true;
+        else if (startsWith(a,"--frames=")) P.benchmarkFrames = std::max(1, toInt(a.substr(9), P.benchmarkFrames));
+        else if (a == "--selfGravity")       P.selfGravity = true;
+        else if (a == "--satCollisions")     P.satCollisions = true;
+        else if (startsWith(a,"--reorder="))   P.reorderEvery = std::max(0, toInt(a.substr(10), P.reorderEvery));
+        else if (a == "--compact")           P.compactBits = 16;
+        else if (startsWith(a,"--compact=")) {
+            std::string m = a.substr(10);
+            if (m == "16" || m == "32") P.compactBits = std::stoi(m);
+            else if (m == "0" || m == "off") P.compactBits = 0;
+            else std::cerr << "[warn] --compact desconocido: " << m << " (16|32|off)\n";
+        }
+        else if (a == "--compact-report")    P.compactReport = true;
+        else if (startsWith(a,"--satRestitution=")) P.satRestitution = clampf(toFloat(a.substr(17), P.satRestitution), 0.f, 1.f);
+        else if (startsWith(a,"--theta="))     P.theta = clampf(toFloat(a.substr(8), P.theta), 0.05f, 2.f);
+        else if (startsWith(a,"--simd=")) {
+            std::string m = a.substr(7);
+            if (m == "auto")        P.simd = SimdLevel::AUTO;
+            else if (m == "scalar") P.simd = SimdLevel::SCALAR;
+            else if (m == "sse")    P.simd = SimdLevel::SSE;
+            else if (m == "avx2")   P.simd = SimdLevel::AVX2;
+            else if (m == "avx512") P.simd = SimdLevel::AVX512;
+            else std::cerr << "[warn] --simd desconocido: " << m << " (auto|scalar|sse|avx2|avx512)\n";
+        }
+        else if (startsWith(a,"--backend=")) {
+            std::string m = a.substr(10);
+            if (m == "serial")      P.backend = Backend::SERIAL;
+            else if (m == "omp")    P.backend = Backend::OMP;
+            else if (m == "stdpar") P.backend = Backend::STDPAR;
+            else if (m == "pool")   P.backend = Backend::POOL;
+            else std::cerr << "[warn] --backend desconocido: " << m << " (serial|omp|stdpar|pool)\n";
+        }
+        else if (startsWith(a,"--render=")) {
+            std::string m = a.substr(9);
+            if (m == "circles")      P.renderMode = RenderMode::CIRCLES;
+            else if (m == "density") P.renderMode = RenderMode::DENSITY;
+            else std::cerr << "[warn] --render desconocido: " << m << " (circles|density)\n";
+        }
+        else if (startsWith(a,"--exposure=")) P.densityExposure = clampf(toFloat(a.substr(11), P.densityExposure), 0.1f, 20.f);
+        else if (startsWith(a,"--bench-mode=")) {
+            std::string m = a.substr(13);
+            P.benchmark = true;
+            if (m == "sim")         P.benchMode = BenchMode::SIM;
+            else if (m == "raster") P.benchMode = BenchMode::RASTER;
+            else if (m == "full")   P.benchMode = BenchMode::FULL;
+            else std::cerr << "[warn] --bench-mode desconocido: " << m << " (sim|raster|full)\n";
+        }
+        else std::cerr << "[warn] Arg no reconocido: " << a << "\n";
+    }
+}
+
+// --compact reemplaza a SatArray: lo que necesita las columnas en float se apaga con
+// aviso. Un checkpoint o un replay traen su propio estado en float y mandan ellos.
+static void resolveCompact(SimParams& P) {
+    if (P.compactBits && (!P.loadCheckpoint.empty() || !P.replay.empty())) {
+        std::cerr << "[warn] --compact no se combina con --load-checkpoint ni --replay, se ignora\n";
+        P.compactBits = 0;
+    }
+    if (!P.compactBits) {
+        if (P.compactReport) std::cerr << "[warn] --compact-report necesita --compact=16|32\n";
+        P.compactReport = false;
+        return;
+    }
+    auto drop = [](bool on, const char* flag) {
+        if (on) std::cerr << "[warn] " << flag << " no funciona con --compact, se ignora\n";
+    };
+    drop(P.selfGravity, "--selfGravity");                 P.selfGravity = false;
+    drop(P.satCollisions, "--satCollisions");             P.satCollisions = false;
+    drop(P.reorderEvery > 0, "--reorder");                P.reorderEvery = 0;
+    drop(!P.trajOut.empty(), "--traj");                   P.trajOut.clear();
+    drop(!P.saveCheckpoint.empty(), "--save-checkpoint"); P.saveCheckpoint.clear();
+}
+
+// ---------------- Kernel de satélites (escalar + SIMD) ----------------
+// Actualiza los satélites [begin,end): cooldown, gravedad, integración, paredes y eyección.
+// Las versiones SIMD procesan 4/8/16 satélites por instrucción y usan máscaras
+// en vez de ramas; el resto (< ancho del vector) pasa por la versión escalar.
+using SatKernelFn = void (*)(SatArray&, int, int, const SimState&, const SimParams&, float);
+
+static inline void updateSatScalar(SatArray& sat, int i, const SimState& S, const SimParams& p, float dt) {
+    const float rad = sat.radius;
+    float x = sat.x[i], y = sat.y[i];
+    float vx = sat.vx[i], vy = sat.vy[i];
+    float cd = sat.cooldown[i];
+    if (cd > 0.f)
+        cd = std::max(0.f, cd - dt);
+
+    applyGravityFromMains(x, y, cd, vx, vy, S.mainsSoA, p, dt);
+
+    x += vx * dt;
+    y += vy * dt;
+
+    bounceWalls(x, y, vx, vy, rad, p);
+
+    checkEjectNearby(x, y, vx, vy, cd, rad, S, p);
+
+    sat.x[i] = x; sat.y[i] = y;
+    sat.vx[i] = vx; sat.vy[i] = vy;
+    sat.cooldown[i] = cd;
+}
+
+static void satKernelScalar(SatArray& sat, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    for (int i = begin; i < end; i++) updateSatScalar(sat, i, S, p, dt);
+}
+
+// Kernel sobre CompactSats: misma física que updateSatScalar, con la decodificación
+// al entrar y la codificación al salir (todo en registros, sin arreglos en float)
+using CompactKernelFn = void (*)(CompactSats&, int, int, const SimState&, const SimParams&, float);
+
+template <class PosT>
+static void satKernelCompact(CompactSats& c, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    const float rad = S.sats.radius;
+    const float W = float(p.width), H = float(p.height);
+    PosT* qx; PosT* qy;
+    c.cols(qx, qy);
+    for (int i = begin; i < end; i++) {
+        float x = float(qx[i]) * c.fromX, y = float(qy[i]) * c.fromY;
+        float vx = halfToFloat(c.vx[i]), vy = halfToFloat(c.vy[i]);
+        float cd = float(c.cooldown[i]) * c.cdFromQ;
+        if (cd > 0.f)
+            cd = std::max(0.f, cd - dt);
+
+        applyGravityFromMains(x, y, cd, vx, vy, S.mainsSoA, p, dt);
+
+        x += vx * dt;
+        y += vy * dt;
+
+        bounceWalls(x, y, vx, vy, rad, p);
+
+        checkEjectNearby(x, y, vx, vy, cd, rad, S, p);
+
+        qx[i] = compactQuant<PosT>(x, W, c.toX);
+        qy[i] = compactQuant<PosT>(y, H, c.toY);
+        c.vx[i] = floatToHalf(clampf(vx, -kHalfMax, kHalfMax));
+        c.vy[i] = floatToHalf(clampf(vy, -kHalfMax, kHalfMax));
+        c.cooldown[i] = Uint8(std::min(255.f, cd * c.cdToQ + 0.5f));
+    }
+}
+
+// Eyección escalar para los carriles marcados en 'lanes' de un bloque SIMD
+// (los kernels la usan solo cuando algún carril cae en una celda con principales)
+static inline void ejectLanes(float* x, float* y, float* vx, float* vy, float* cd, const int* cells,
+                              unsigned lanes, const SimState& S, float rad, const SimParams& p) {
+    const MainIndex& I = S.mainIndex;
+    while (lanes) {
+        const int l = __builtin_ctz(lanes);
+        lanes &= lanes - 1;
+        const int c = cells[l];
+        for (int k = I.start[c]; k < I.start[c + 1]; k++)
+            checkEject(x[l], y[l], vx[l], vy[l], cd[l], rad, S.mains[I.list[k]], p);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAT_SIMD_X86 1
+
+// SSE4.1: 4 satélites por instrucción
+__attribute__((target("sse4.1")))
+static void satKernelSSE(SatArray& sat, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    const MainsSoA& M = S.mainsSoA;
+    const MainIndex& I = S.mainIndex;
+    const float ecs = p.ejectCooldownSec;
+    const __m128 vdt   = _mm_set1_ps(dt);
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps(1.f);
+    const __m128 half  = _mm_set1_ps(0.5f);
+    const __m128 three = _mm_set1_ps(3.f);
+    const __m128 soft2 = _mm_set1_ps(p.softening * p.softening);
+    const __m128 rad   = _mm_set1_ps(sat.radius);
+    const __m128 rest  = _mm_set1_ps(p.wallRestitution);
+    const __m128 W     = _mm_set1_ps((float)p.width);
+    const __m128 H     = _mm_set1_ps((float)p.height);
+    const __m128 Wr    = _mm_set1_ps(p.width - sat.radius);
+    const __m128 Hr    = _mm_set1_ps(p.height - sat.radius);
+    const __m128 vecs  = _mm_set1_ps(ecs);
+    const __m128 post  = _mm_set1_ps(p.postEjectGravityFactor);
+    const __m128 cinv  = _mm_set1_ps(I.inv);
+    const __m128i izero = _mm_setzero_si128();
+    const __m128i gxv  = _mm_set1_epi32(I.gx);
+    const __m128i gxm1 = _mm_set1_epi32(I.gx - 1);
+    const __m128i gym1 = _mm_set1_epi32(I.gy - 1);
+
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 x  = _mm_loadu_ps(&sat.x[i]),  y  = _mm_loadu_ps(&sat.y[i]);
+        __m128 vx = _mm_loadu_ps(&sat.vx[i]), vy = _mm_loadu_ps(&sat.vy[i]);
+        __m128 cd = _mm_loadu_ps(&sat.cooldown[i]);
+        cd = _mm_max_ps(zero, _mm_sub_ps(cd, vdt));
+
+        // Rampa de gravedad durante el cooldown
+        __m128 factor = one;
+        if (ecs > 0.f) {
+            __m128 t = _mm_sub_ps(one, _mm_min_ps(one, _mm_max_ps(zero, _mm_div_ps(cd, vecs))));
+            __m128 f = _mm_add_ps(post, _mm_mul_ps(_mm_sub_ps(one, post), t));
+            factor = _mm_blendv_ps(one, f, _mm_cmpgt_ps(cd, zero));
+        }
+        const __m128 fdt = _mm_mul_ps(factor, vdt);
+
+        for (int k = 0; k < M.count; k++) {
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(M.x[k]), x);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(M.y[k]), y);
+            __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), soft2);
+            __m128 ir = _mm_rsqrt_ps(r2);
+            ir = _mm_mul_ps(_mm_mul_ps(half, ir), _mm_sub_ps(three, _mm_mul_ps(_mm_mul_ps(r2, ir), ir)));
+            __m128 s = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(M.gm[k]), fdt),
+                                  _mm_mul_ps(_mm_mul_ps(ir, ir), ir));
+            vx = _mm_add_ps(vx, _mm_mul_ps(s, dx));
+            vy = _mm_add_ps(vy, _mm_mul_ps(s, dy));
+        }
+
+        x = _mm_add_ps(x, _mm_mul_ps(vx, vdt));
+        y = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+
+        // Paredes (mismo orden que bounceWalls)
+        __m128 m;
+        m  = _mm_cmplt_ps(_mm_sub_ps(x, rad), zero);
+        x  = _mm_blendv_ps(x, rad, m);
+        vx = _mm_blendv_ps(vx, _mm_mul_ps(_mm_sub_ps(zero, vx), rest), m);
+        m  = _mm_cmpgt_ps(_mm_add_ps(x, rad), W);
+        x  = _mm_blendv_ps(x, Wr, m);
+        vx = _mm_blendv_ps(vx, _mm_mul_ps(_mm_sub_ps(zero, vx), rest), m);
+        m  = _mm_cmplt_ps(_mm_sub_ps(y, rad), zero);
+        y  = _mm_blendv_ps(y, rad, m);
+        vy = _mm_blendv_ps(vy, _mm_mul_ps(_mm_sub_ps(zero, vy), rest), m);
+        m  = _mm_cmpgt_ps(_mm_add_ps(y, rad), H);
+        y  = _mm_blendv_ps(y, Hr, m);
+        vy = _mm_blendv_ps(vy, _mm_mul_ps(_mm_sub_ps(zero, vy), rest), m);
+
+        // Eyección: celda de cada carril en el índice de principales; casi siempre
+        // vacía, así que el bloque se salta si ningún carril tiene candidatos
+        __m128i cx = _mm_min_epi32(gxm1, _mm_max_epi32(izero, _mm_cvttps_epi32(_mm_mul_ps(x, cinv))));
+        __m128i cy = _mm_min_epi32(gym1, _mm_max_epi32(izero, _mm_cvttps_epi32(_mm_mul_ps(y, cinv))));
+        alignas(16) int cells[4];
+        _mm_store_si128((__m128i*)cells, _mm_add_epi32(_mm_mullo_epi32(cy, gxv), cx));
+        unsigned lanes = 0;
+        for (int l = 0; l < 4; l++) if (I.count[cells[l]] > 0) lanes |= 1u << l;
+        if (lanes) {
+            alignas(16) float lx[4], ly[4], lvx[4], lvy[4], lcd[4];
+            _mm_store_ps(lx, x);   _mm_store_ps(ly, y);
+            _mm_store_ps(lvx, vx); _mm_store_ps(lvy, vy); _mm_store_ps(lcd, cd);
+            ejectLanes(lx, ly, lvx, lvy, lcd, cells, lanes, S, sat.radius, p);
+            x = _mm_load_ps(lx);   y = _mm_load_ps(ly);
+            vx = _mm_load_ps(lvx); vy = _mm_load_ps(lvy); cd = _mm_load_ps(lcd);
+        }
+
+        _mm_storeu_ps(&sat.x[i], x);   _mm_storeu_ps(&sat.y[i], y);
+        _mm_storeu_ps(&sat.vx[i], vx); _mm_storeu_ps(&sat.vy[i], vy);
+        _mm_storeu_ps(&sat.cooldown[i], cd);
+    }
+    for (; i < end; i++) updateSatScalar(sat, i, S, p, dt);
+}
+
+// AVX2 + FMA: 8 satélites por instrucción
+__attribute__((target("avx2,fma")))
+static void satKernelAVX2(SatArray& sat, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    const MainsSoA& M = S.mainsSoA;
+    const MainIndex& I = S.mainIndex;
+    const float ecs = p.ejectCooldownSec;
+    const __m256 vdt   = _mm256_set1_ps(dt);
+    const __m256 zero  = _mm256_setzero_ps();
+    const __m256 one   = _mm256_set1_ps(1.f);
+    const __m256 half  = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.f);
+    const __m256 soft2 = _mm256_set1_ps(p.softening * p.softening);
+    const __m256 rad   = _mm256_set1_ps(sat.radius);
+    const __m256 rest  = _mm256_set1_ps(p.wallRestitution);
+    const __m256 W     = _mm256_set1_ps((float)p.width);
+    const __m256 H     = _mm256_set1_ps((float)p.height);
+    const __m256 Wr    = _mm256_set1_ps(p.width - sat.radius);
+    const __m256 Hr    = _mm256_set1_ps(p.height - sat.radius);
+    const __m256 vecs  = _mm256_set1_ps(ecs);
+    const __m256 post  = _mm256_set1_ps(p.postEjectGravityFactor);
+    const __m256 cinv  = _mm256_set1_ps(I.inv);
+    const __m256i izero = _mm256_setzero_si256();
+    const __m256i gxv  = _mm256_set1_epi32(I.gx);
+    const __m256i gxm1 = _mm256_set1_epi32(I.gx - 1);
+    const __m256i gym1 = _mm256_set1_epi32(I.gy - 1);
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x  = _mm256_loadu_ps(&sat.x[i]),  y  = _mm256_loadu_ps(&sat.y[i]);
+        __m256 vx = _mm256_loadu_ps(&sat.vx[i]), vy = _mm256_loadu_ps(&sat.vy[i]);
+        __m256 cd = _mm256_loadu_ps(&sat.cooldown[i]);
+        cd = _mm256_max_ps(zero, _mm256_sub_ps(cd, vdt));
+
+        __m256 factor = one;
+        if (ecs > 0.f) {
+            __m256 t = _mm256_sub_ps(one, _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(cd, vecs))));
+            __m256 f = _mm256_fmadd_ps(_mm256_sub_ps(one, post), t, post);
+            factor = _mm256_blendv_ps(one, f, _mm256_cmp_ps(cd, zero, _CMP_GT_OQ));
+        }
+        const __m256 fdt = _mm256_mul_ps(factor, vdt);
+
+        for (int k = 0; k < M.count; k++) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(M.x[k]), x);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(M.y[k]), y);
+            __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, soft2));
+            __m256 ir = _mm256_rsqrt_ps(r2);
+            ir = _mm256_mul_ps(_mm256_mul_ps(half, ir), _mm256_fnmadd_ps(_mm256_mul_ps(r2, ir), ir, three));
+            __m256 s = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(M.gm[k]), fdt),
+                                     _mm256_mul_ps(_mm256_mul_ps(ir, ir), ir));
+            vx = _mm256_fmadd_ps(s, dx, vx);
+            vy = _mm256_fmadd_ps(s, dy, vy);
+        }
+
+        x = _mm256_fmadd_ps(vx, vdt, x);
+        y = _mm256_fmadd_ps(vy, vdt, y);
+
+        __m256 m;
+        m  = _mm256_cmp_ps(_mm256_sub_ps(x, rad), zero, _CMP_LT_OQ);
+        x  = _mm256_blendv_ps(x, rad, m);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_sub_ps(zero, vx), rest), m);
+        m  = _mm256_cmp_ps(_mm256_add_ps(x, rad), W, _CMP_GT_OQ);
+        x  = _mm256_blendv_ps(x, Wr, m);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_sub_ps(zero, vx), rest), m);
+        m  = _mm256_cmp_ps(_mm256_sub_ps(y, rad), zero, _CMP_LT_OQ);
+        y  = _mm256_blendv_ps(y, rad, m);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_sub_ps(zero, vy), rest), m);
+        m  = _mm256_cmp_ps(_mm256_add_ps(y, rad), H, _CMP_GT_OQ);
+        y  = _mm256_blendv_ps(y, Hr, m);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_sub_ps(zero, vy), rest), m);
+
+        // Eyección: gather del conteo de principales en la celda de cada carril
+        __m256i cx = _mm256_min_epi32(gxm1, _mm256_max_epi32(izero, _mm256_cvttps_epi32(_mm256_mul_ps(x, cinv))));
+        __m256i cy = _mm256_min_epi32(gym1, _mm256_max_epi32(izero, _mm256_cvttps_epi32(_mm256_mul_ps(y, cinv))));
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(cy, gxv), cx);
+        __m256i cnt  = _mm256_i32gather_epi32(I.count.data(), cell, 4);
+        unsigned lanes = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cnt, izero)));
+        if (lanes) {
+            alignas(32) float lx[8], ly[8], lvx[8], lvy[8], lcd[8];
+            alignas(32) int cells[8];
+            _mm256_store_si256((__m256i*)cells, cell);
+            _mm256_store_ps(lx, x);   _mm256_store_ps(ly, y);
+            _mm256_store_ps(lvx, vx); _mm256_store_ps(lvy, vy); _mm256_store_ps(lcd, cd);
+            ejectLanes(lx, ly, lvx, lvy, lcd, cells, lanes, S, sat.radius, p);
+            x = _mm256_load_ps(lx);   y = _mm256_load_ps(ly);
+            vx = _mm256_load_ps(lvx); vy = _mm256_load_ps(lvy); cd = _mm256_load_ps(lcd);
+        }
+
+        _mm256_storeu_ps(&sat.x[i], x);   _mm256_storeu_ps(&sat.y[i], y);
+        _mm256_storeu_ps(&sat.vx[i], vx); _mm256_storeu_ps(&sat.vy[i], vy);
+        _mm256_storeu_ps(&sat.cooldown[i], cd);
+    }
+    for (; i < end; i++) updateSatScalar(sat, i, S, p, dt);
+}
+
+// AVX-512F: 16 satélites por instrucción, máscaras nativas (__mmask16)
+// (GCC 12 avisa de falsos "maybe-uninitialized" dentro de avx512fintrin.h)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static void satKernelAVX512(SatArray& sat, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    const MainsSoA& M = S.mainsSoA;
+    const MainIndex& I = S.mainIndex;
+    const float ecs = p.ejectCooldownSec;
+    const __m512 vdt   = _mm512_set1_ps(dt);
+    const __m512 zero  = _mm512_setzero_ps();
+    const __m512 one   = _mm512_set1_ps(1.f);
+    const __m512 half  = _mm512_set1_ps(0.5f);
+    const __m512 three = _mm512_set1_ps(3.f);
+    const __m512 soft2 = _mm512_set1_ps(p.softening * p.softening);
+    const __m512 rad   = _mm512_set1_ps(sat.radius);
+    const __m512 nrest = _mm512_set1_ps(-p.wallRestitution);
+    const __m512 W     = _mm512_set1_ps((float)p.width);
+    const __m512 H     = _mm512_set1_ps((float)p.height);
+    const __m512 Wr    = _mm512_set1_ps(p.width - sat.radius);
+    const __m512 Hr    = _mm512_set1_ps(p.height - sat.radius);
+    const __m512 vecs  = _mm512_set1_ps(ecs);
+    const __m512 post  = _mm512_set1_ps(p.postEjectGravityFactor);
+    const __m512 cinv  = _mm512_set1_ps(I.inv);
+    const __m512i izero = _mm512_setzero_si512();
+    const __m512i gxv  = _mm512_set1_epi32(I.gx);
+    const __m512i gxm1 = _mm512_set1_epi32(I.gx - 1);
+    const __m512i gym1 = _mm512_set1_epi32(I.gy - 1);
+
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 x  = _mm512_loadu_ps(&sat.x[i]),  y  = _mm512_loadu_ps(&sat.y[i]);
+        __m512 vx = _mm512_loadu_ps(&sat.vx[i]), vy = _mm512_loadu_ps(&sat.vy[i]);
+        __m512 cd = _mm512_loadu_ps(&sat.cooldown[i]);
+        cd = _mm512_max_ps(zero, _mm512_sub_ps(cd, vdt));
+
+        __m512 factor = one;
+        if (ecs > 0.f) {
+            __m512 t = _mm512_sub_ps(one, _mm512_min_ps(one, _mm512_max_ps(zero, _mm512_div_ps(cd, vecs))));
+            __m512 f = _mm512_fmadd_ps(_mm512_sub_ps(one, post), t, post);
+            factor = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(cd, zero, _CMP_GT_OQ), one, f);
+        }
+        const __m512 fdt = _mm512_mul_ps(factor, vdt);
+
+        for (int k = 0; k < M.count; k++) {
+            __m512 dx = _mm512_sub_ps(_mm512_set1_ps(M.x[k]), x);
+            __m512 dy = _mm512_sub_ps(_mm512_set1_ps(M.y[k]), y);
+            __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, soft2));
+            __m512 ir = _mm512_rsqrt14_ps(r2);
+            ir = _mm512_mul_ps(_mm512_mul_ps(half, ir), _mm512_fnmadd_ps(_mm512_mul_ps(r2, ir), ir, three));
+            __m512 s = _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(M.gm[k]), fdt),
+                                     _mm512_mul_ps(_mm512_mul_ps(ir, ir), ir));
+            vx = _mm512_fmadd_ps(s, dx, vx);
+            vy = _mm512_fmadd_ps(s, dy, vy);
+        }
+
+        x = _mm512_fmadd_ps(vx, vdt, x);
+        y = _mm512_fmadd_ps(vy, vdt, y);
+
+        __mmask16 m;
+        m  = _mm512_cmp_ps_mask(_mm512_sub_ps(x, rad), zero, _CMP_LT_OQ);
+        x  = _mm512_mask_mov_ps(x, m, rad);
+        vx = _mm512_mask_mul_ps(vx, m, vx, nrest);
+        m  = _mm512_cmp_ps_mask(_mm512_add_ps(x, rad), W, _CMP_GT_OQ);
+        x  = _mm512_mask_mov_ps(x, m, Wr);
+        vx = _mm512_mask_mul_ps(vx, m, vx, nrest);
+        m  = _mm512_cmp_ps_mask(_mm512_sub_ps(y, rad), zero, _CMP_LT_OQ);
+        y  = _mm512_mask_mov_ps(y, m, rad);
+        vy = _mm512_mask_mul_ps(vy, m, vy, nrest);
+        m  = _mm512_cmp_ps_mask(_mm512_add_ps(y, rad), H, _CMP_GT_OQ);
+        y  = _mm512_mask_mov_ps(y, m, Hr);
+        vy = _mm512_mask_mul_ps(vy, m, vy, nrest);
+
+        __m512i cx = _mm512_min_epi32(gxm1, _mm512_max_epi32(izero, _mm512_cvttps_epi32(_mm512_mul_ps(x, cinv))));
+        __m512i cy = _mm512_min_epi32(gym1, _mm512_max_epi32(izero, _mm512_cvttps_epi32(_mm512_mul_ps(y, cinv))));
+        __m512i cell = _mm512_add_epi32(_mm512_mullo_epi32(cy, gxv), cx);
+        __m512i cnt  = _mm512_i32gather_epi32(cell, I.count.data(), 4);
+        unsigned lanes = (unsigned)_mm512_cmpgt_epi32_mask(cnt, izero);
+        if (lanes) {
+            alignas(64) float lx[16], ly[16], lvx[16], lvy[16], lcd[16];
+            alignas(64) int cells[16];
+            _mm512_store_si512(cells, cell);
+            _mm512_store_ps(lx, x);   _mm512_store_ps(ly, y);
+            _mm512_store_ps(lvx, vx); _mm512_store_ps(lvy, vy); _mm512_store_ps(lcd, cd);
+            ejectLanes(lx, ly, lvx, lvy, lcd, cells, lanes, S, sat.radius, p);
+            x = _mm512_load_ps(lx);   y = _mm512_load_ps(ly);
+            vx = _mm512_load_ps(lvx); vy = _mm512_load_ps(lvy); cd = _mm512_load_ps(lcd);
+        }
+
+        _mm512_storeu_ps(&sat.x[i], x);   _mm512_storeu_ps(&sat.y[i], y);
+        _mm512_storeu_ps(&sat.vx[i], vx); _mm512_storeu_ps(&sat.vy[i], vy);
+        _mm512_storeu_ps(&sat.cooldown[i], cd);
+    }
+    for (; i < end; i++) updateSatScalar(sat, i, S, p, dt);
+}
+#pragma GCC diagnostic pop
+// CompactSats con AVX2 + FMA + F16C: 8 satélites por instrucción. Misma física que
+// satKernelAVX2; la decodificación (enteros -> float, half -> float con vcvtph2ps)
+// y la codificación quedan en registros entre la carga y el store.
+__attribute__((target("avx2,fma,f16c")))
+static inline __m256 compactLoadPos(const Uint16* q, __m256 from) {
+    const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)q));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(v), from);
+}
+__attribute__((target("avx2,fma,f16c")))
+static inline __m256 compactLoadPos(const Uint32* q, __m256 from) {
+    // sin conversión u32 -> float en AVX2: mitades de 16 bits, una sola suma redondea
+    const __m256i v  = _mm256_loadu_si256((const __m256i*)q);
+    const __m256 hi = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16));
+    const __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xFFFF)));
+    return _mm256_mul_ps(_mm256_fmadd_ps(hi, _mm256_set1_ps(65536.f), lo), from);
+}
+__attribute__((target("avx2,fma,f16c")))
+static inline void compactStorePos(Uint16* q, __m256 v, __m256 limit, __m256 to) {
+    v = _mm256_min_ps(limit, _mm256_max_ps(_mm256_setzero_ps(), v));
+    const __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, to), _mm256_set1_ps(0.5f)));
+    _mm_storeu_si128((__m128i*)q, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+__attribute__((target("avx2,fma,f16c")))
+static inline void compactStorePos(Uint32* q, __m256 v, __m256 limit, __m256 to) {
+    v = _mm256_min_ps(limit, _mm256_max_ps(_mm256_setzero_ps(), v));
+    __m256 f = _mm256_add_ps(_mm256_mul_ps(v, to), _mm256_set1_ps(0.5f));
+    // cvttps solo llega a 2^31: los carriles grandes se corren 2^31 y se vuelve a poner el bit
+    const __m256 two31 = _mm256_set1_ps(2147483648.f);
+    const __m256 big = _mm256_cmp_ps(f, two31, _CMP_GE_OQ);
+    f = _mm256_sub_ps(f, _mm256_and_ps(big, two31));
+    const __m256i i = _mm256_xor_si256(_mm256_cvttps_epi32(f),
+                                       _mm256_and_si256(_mm256_castps_si256(big), _mm256_set1_epi32(int(0x80000000u))));
+    _mm256_storeu_si256((__m256i*)q, i);
+}
+
+template <class PosT>
+__attribute__((target("avx2,fma,f16c")))
+static void satKernelCompactAVX2(CompactSats& c, int begin, int end, const SimState& S, const SimParams& p, float dt) {
+    const MainsSoA& M = S.mainsSoA;
+    const MainIndex& I = S.mainIndex;
+    const float satR = S.sats.radius;
+    const float ecs = p.ejectCooldownSec;
+    const __m256 vdt   = _mm256_set1_ps(dt);
+    const __m256 zero  = _mm256_setzero_ps();
+    const __m256 one   = _mm256_set1_ps(1.f);
+    const __m256 half  = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.f);
+    const __m256 soft2 = _mm256_set1_ps(p.softening * p.softening);
+    const __m256 rad   = _mm256_set1_ps(satR);
+    const __m256 rest  = _mm256_set1_ps(p.wallRestitution);
+    const __m256 W     = _mm256_set1_ps((float)p.width);
+    const __m256 H     = _mm256_set1_ps((float)p.height);
+    const __m256 Wr    = _mm256_set1_ps(p.width - satR);
+    const __m256 Hr    = _mm256_set1_ps(p.height - satR);
+    const __m256 vecs  = _mm256_set1_ps(ecs);
+    const __m256 post  = _mm256_set1_ps(p.postEjectGravityFactor);
+    const __m256 cinv  = _mm256_set1_ps(I.inv);
+    const __m256i izero = _mm256_setzero_si256();
+    const __m256i gxv  = _mm256_set1_epi32(I.gx);
+    const __m256i gxm1 = _mm256_set1_epi32(I.gx - 1);
+    const __m256i gym1 = _mm256_set1_epi32(I.gy - 1);
+    const __m256 fromX = _mm256_set1_ps(c.fromX), fromY = _mm256_set1_ps(c.fromY);
+    const __m256 toX   = _mm256_set1_ps(c.toX),   toY   = _mm256_set1_ps(c.toY);
+    const __m256 cdFrom = _mm256_set1_ps(c.cdFromQ), cdTo = _mm256_set1_ps(c.cdToQ);
+    const __m256 cdMax = _mm256_set1_ps(255.f);
+    const __m256 vmax  = _mm256_set1_ps(kHalfMax), vmin = _mm256_set1_ps(-kHalfMax);
+    PosT* qx; PosT* qy;
+    c.cols(qx, qy);
+
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x  = compactLoadPos(&qx[i], fromX), y = compactLoadPos(&qy[i], fromY);
+        __m256 vx = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)&c.vx[i]));
+        __m256 vy = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)&c.vy[i]));
+        __m256 cd = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&c.cooldown[i]))), cdFrom);
+        cd = _mm256_max_ps(zero, _mm256_sub_ps(cd, vdt));
+
+        __m256 factor = one;
+        if (ecs > 0.f) {
+            __m256 t = _mm256_sub_ps(one, _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(cd, vecs))));
+            __m256 f = _mm256_fmadd_ps(_mm256_sub_ps(one, post), t, post);
+            factor = _mm256_blendv_ps(one, f, _mm256_cmp_ps(cd, zero, _CMP_GT_OQ));
+        }
+        const __m256 fdt = _mm256_mul_ps(factor, vdt);
+
+        for (int k = 0; k < M.count; k++) {
+            __m256 dx = _mm256_sub_ps(_mm256_set1_ps(M.x[k]), x);
+            __m256 dy = _mm256_sub_ps(_mm256_set1_ps(M.y[k]), y);
+            __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, soft2));
+            __m256 ir = _mm256_rsqrt_ps(r2);
+            ir = _mm256_mul_ps(_mm256_mul_ps(half, ir), _mm256_fnmadd_ps(_mm256_mul_ps(r2, ir), ir, three));
+            __m256 s = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(M.gm[k]), fdt),
+                                     _mm256_mul_ps(_mm256_mul_ps(ir, ir), ir));
+            vx = _mm256_fmadd_ps(s, dx, vx);
+            vy = _mm256_fmadd_ps(s, dy, vy);
+        }
+
+        x = _mm256_fmadd_ps(vx, vdt, x);
+        y = _mm256_fmadd_ps(vy, vdt, y);
+
+        __m256 m;
+        m  = _mm256_cmp_ps(_mm256_sub_ps(x, rad), zero, _CMP_LT_OQ);
+        x  = _mm256_blendv_ps(x, rad, m);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_sub_ps(zero, vx), rest), m);
+        m  = _mm256_cmp_ps(_mm256_add_ps(x, rad), W, _CMP_GT_OQ);
+        x  = _mm256_blendv_ps(x, Wr, m);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_sub_ps(zero, vx), rest), m);
+        m  = _mm256_cmp_ps(_mm256_sub_ps(y, rad), zero, _CMP_LT_OQ);
+        y  = _mm256_blendv_ps(y, rad, m);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_sub_ps(zero, vy), rest), m);
+        m  = _mm256_cmp_ps(_mm256_add_ps(y, rad), H, _CMP_GT_OQ);
+        y  = _mm256_blendv_ps(y, Hr, m);
+        vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_sub_ps(zero, vy), rest), m);
+
+        __m256i cx = _mm256_min_epi32(gxm1, _mm256_max_epi32(izero, _mm256_cvttps_epi32(_mm256_mul_ps(x, cinv))));
+        __m256i cy = _mm256_min_epi32(gym1, _mm256_max_epi32(izero, _mm256_cvttps_epi32(_mm256_mul_ps(y, cinv))));
+        __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(cy, gxv), cx);
+        __m256i cnt  = _mm256_i32gather_epi32(I.count.data(), cell, 4);
+        unsigned lanes = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cnt, izero)));
+        if (lanes) {
+            alignas(32) float lx[8], ly[8], lvx[8], lvy[8], lcd[8];
+            alignas(32) int cells[8];
+            _mm256_store_si256((__m256i*)cells, cell);
+            _mm256_store_ps(lx, x);   _mm256_store_ps(ly, y);
+            _mm256_store_ps(lvx, vx); _mm256_store_ps(lvy, vy); _mm256_store_ps(lcd, cd);
+            ejectLanes(lx, ly, lvx, lvy, lcd, cells, lanes, S, satR, p);
+            x = _mm256_load_ps(lx);   y = _mm256_load_ps(ly);
+            vx = _mm256_load_ps(lvx); vy = _mm256_load_ps(lvy); cd = _mm256_load_ps(lcd);
+        }
+
+        compactStorePos(&qx[i], x, W, toX);
+        compactStorePos(&qy[i], y, H, toY);
+        vx = _mm256_min_ps(vmax, _mm256_max_ps(vmin, vx));
+        vy = _mm256_min_ps(vmax, _mm256_max_ps(vmin, vy));
+        _mm_storeu_si128((__m128i*)&c.vx[i], _mm256_cvtps_ph(vx, _MM_FROUND_TO_NEAREST_INT));
+        _mm_storeu_si128((__m128i*)&c.vy[i], _mm256_cvtps_ph(vy, _MM_FROUND_TO_NEAREST_INT));
+        const __m256i qc = _mm256_cvttps_epi32(_mm256_min_ps(cdMax, _mm256_fmadd_ps(cd, cdTo, half)));
+        const __m128i c16 = _mm_packus_epi32(_mm256_castsi256_si128(qc), _mm256_extracti128_si256(qc, 1));
+        _mm_storel_epi64((__m128i*)&c.cooldown[i], _mm_packus_epi16(c16, c16));
+    }
+    satKernelCompact<PosT>(c, i, end, S, p, dt);
+}
+
+#endif // SAT_SIMD_X86
+
+// Mejor nivel que soporta la CPU actual (CPUID vía __builtin_cpu_supports)
+static SimdLevel detectSimd() {
+#ifdef SAT_SIMD_X86
+    __builtin_cpu_init();
+    // Los niveles son acumulativos: AVX2 exige también FMA y F16C (el kernel compacto
+    // usa las conversiones half de F16C) y AVX512 exige además todo lo de AVX2
+    const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                      __builtin_cpu_supports("f16c");
+    if (avx2 && __builtin_cpu_supports("avx512f"))                          return SimdLevel::AVX512;
+    if (avx2)                                                               return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))                                   return SimdLevel::SSE;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// AUTO -> el mejor disponible; si se fuerza uno que la CPU no tiene, se baja al mejor soportado
+static SimdLevel resolveSimd(SimdLevel req) {
+    SimdLevel best = detectSimd();
+    if (req == SimdLevel::AUTO) return best;
+    if ((int)req > (int)best) {
+        std::cerr << "[warn] --simd=" << simdLabel(req) << " no soportado por esta CPU, usando "
+                  << simdLabel(best) << "\n";
+        return best;
+    }
+    return req;
+}
+
+static SatKernelFn satKernelFor(SimdLevel level) {
+    switch (level) {
+#ifdef SAT_SIMD_X86
+        case SimdLevel::AVX512: return satKernelAVX512;
+        case SimdLevel::AVX2:   return satKernelAVX2;
+        case SimdLevel::SSE:    return satKernelSSE;
+#endif
+        default:                return satKernelScalar;
+    }
+}
+
+// Con nivel AVX2 o AVX512 el kernel compacto AVX2+F16C; si no, el escalar. Ambos
+// niveles ya exigen F16C en detectSimd (y resolveSimd no deja pasar uno que la CPU
+// no tenga), así que no se consulta la CPU en cada paso.
+static CompactKernelFn compactKernelFor(int bits, SimdLevel level) {
+#ifdef SAT_SIMD_X86
+    if (int(level) >= int(SimdLevel::AVX2))
+        return (bits == 16) ? satKernelCompactAVX2<Uint16> : satKernelCompactAVX2<Uint32>;
+#else
+    (void)level;
+#endif
+    return (bits == 16) ? satKernelCompact<Uint16> : satKernelCompact<Uint32>;
+}
+
+// ---------------- Orden Morton + radix sort paralelo ----------------
+// Código Morton (Z-curve) de 32 bits: 16 bits por eje sobre [0,W)x[0,H)
+static inline Uint32 mortonSpread16(Uint32 v) {
+    v &= 0x0000FFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+static inline Uint32 mortonCode(float x, float y, float invW, float invH) {
+    Uint32 ix = (Uint32)clampf(x * invW * 65536.f, 0.f, 65535.f);
+    Uint32 iy = (Uint32)clampf(y * invH * 65536.f, 0.f, 65535.f);
+    return (mortonSpread16(iy) << 1) | mortonSpread16(ix);
+}
+
+// LSD radix sort estable de pares (clave, valor) de 32 bits, 4 pasadas de 8 bits.
+// Histogramas por hilo sobre rangos contiguos -> prefijo (dígito, hilo) -> scatter.
+// Las pasadas donde todas las claves comparten dígito se saltan.
+static void radixSortPairs(AlignedVec<Uint32>& keys, AlignedVec<Uint32>& vals,
+                           AlignedVec<Uint32>& tmpK, AlignedVec<Uint32>& tmpV) {
+    const int n = (int)keys.size();
+    tmpK.resize(n); tmpV.resize(n);
+    const int maxThreads = omp_get_max_threads();
+    std::vector<Uint32> hist((std::size_t)maxThreads * 256);
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        bool skip = false;
+        #pragma omp parallel
+        {
+            const int t = omp_get_thread_num(), nth = omp_get_num_threads();
+            const int b = (int)((long long)n * t / nth), e = (int)((long long)n * (t + 1) / nth);
+            Uint32* h = &hist[(std::size_t)t * 256];
+            std::fill(h, h + 256, 0u);
+            for (int i = b; i < e; i++) h[(keys[i] >> shift) & 0xFF]++;
+            #pragma omp barrier
+            #pragma omp single
+            {
+                Uint32 acc = 0;
+                for (int d = 0; d < 256; d++) {
+                    Uint32 digitTotal = 0;
+                    for (int th = 0; th < nth; th++) {
+                        Uint32& c = hist[(std::size_t)th * 256 + d];
+                        Uint32 cnt = c;
+                        c = acc;
+                        acc += cnt;
+                        digitTotal += cnt;
+                    }
+                    if (digitTotal == (Uint32)n) skip = true;
+                }
+            }
+            if (!skip) {
+                for (int i = b; i < e; i++) {
+                    Uint32 pos = h[(keys[i] >> shift) & 0xFF]++;
+                    tmpK[pos] = keys[i];
+                    tmpV[pos] = vals[i];
+                }
+            }
+        }
+        if (!skip) { keys.swap(tmpK); vals.swap(tmpV); }
+    }
+}
+
+// ---------------- Reordenamiento Morton de satélites ----------------
+// Cada --reorder=K pasos los arreglos SoA se permutan en orden Z-curve: vecinos en
+// pantalla quedan vecinos en memoria y el raster (y las búsquedas por grilla o
+// Barnes-Hut) recorren líneas de caché contiguas. La simulación no depende del
+// índice salvo por el orden de resolución de choques, que sigue siendo determinista.
+struct SatReorder {
+    AlignedVec<Uint32> codes, order, tmpK, tmpV;
+    AlignedVec<float>  tmpF;
+    AlignedVec<Uint32> tmpC;
+    int sinceLast = 0;       // pasos desde el último reordenamiento
+    double ms = 0.0;
+    int count = 0;
+};
+static SatReorder gReorder;
+
+// Cuenta un paso y dice si toca reordenar antes de darlo. Se llama antes del
+// snapshot del Interpolator para que prev y actual usen la misma permutación.
+static bool reorderDue(const SimParams& p) {
+    if (p.reorderEvery <= 0) return false;
+    if (++gReorder.sinceLast < p.reorderEvery) return false;
+    gReorder.sinceLast = 0;
+    return true;
+}
+
+template <class T>
+static void gatherInto(AlignedVec<T>& a, AlignedVec<T>& tmp, const AlignedVec<Uint32>& order) {
+    const int n = (int)a.size();
+    tmp.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < n; k++) tmp[k] = a[order[k]];
+    a.swap(tmp);
+}
+
+static void reorderSats(SatArray& sat, const SimParams& p) {
+    const double t0 = omp_get_wtime();
+    SatReorder& R = gReorder;
+    const int n = (int)sat.size();
+    const float invW = 1.f / float(p.width), invH = 1.f / float(p.height);
+    R.codes.resize(n); R.order.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        R.codes[i] = mortonCode(sat.x[i], sat.y[i], invW, invH);
+        R.order[i] = (Uint32)i;
+    }
+    radixSortPairs(R.codes, R.order, R.tmpK, R.tmpV);
+
+    gatherInto(sat.x, R.tmpF, R.order);
+    gatherInto(sat.y, R.tmpF, R.order);
+    gatherInto(sat.vx, R.tmpF, R.order);
+    gatherInto(sat.vy, R.tmpF, R.order);
+    gatherInto(sat.cooldown, R.tmpF, R.order);
+    gatherInto(sat.color, R.tmpC, R.order);
+    sat.generation++;
+    R.ms += (omp_get_wtime() - t0) * 1000.0;
+    R.count++;
+}
+
+// ---------------- Barnes-Hut (auto-gravedad de satélites) ----------------
+// Quadtree sobre los satélites ordenados por Morton. Cada frame:
+//   1) códigos Morton + radix sort paralelo, 2) subárboles por celda del nivel
+//   kBHTopLevel construidos en paralelo, 3) niveles superiores + rebase,
+//   4) recorrido paralelo por hojas con criterio de apertura size/d < theta
+//      (d incluye el softening).
+static constexpr int kBHLeafSize = 16;
+static constexpr int kBHMaxLevel = 16; // 16 bits por eje en el código Morton
+static constexpr int kBHTopLevel = 3;  // 4^3 = 64 subárboles en paralelo
+
+struct BHNode {
+    float cx = 0, cy = 0;  // centro de masa
+    float mass = 0;
+    float size = 0;        // lado de la celda (max de ancho/alto)
+    int child[4] = { -1, -1, -1, -1 };
+    int begin = 0, end = 0; // rango de satélites (orden Morton)
+    bool leaf = false;
+};
+
+struct BarnesHut {
+    AlignedVec<Uint32> codes, order, tmpK, tmpV;
+    AlignedVec<float> px, py;              // posiciones en orden Morton
+    std::vector<BHNode> nodes;             // nodos superiores + subárboles, raíz = 0
+    std::vector<std::vector<BHNode>> sub;  // un subárbol por celda de nivel kBHTopLevel
+    std::vector<int> leaves;               // índices de hojas (unidad del recorrido)
+    double buildMs = 0.0, walkMs = 0.0;    // acumulados (para el benchmark)
+    int frames = 0;
+};
+static BarnesHut gBH;
+
+// Construye recursivamente el nodo de [b,e) en 'level'; devuelve su índice en 'out'
+static int bhBuild(BarnesHut& T, int b, int e, int level, float rootSize, float satMass, std::vector<BHNode>& out) {
+    const int id = (int)out.size();
+    out.emplace_back();
+    BHNode nd;
+    nd.begin = b; nd.end = e;
+    nd.size = rootSize / float(1 << level);
+
+    if (e - b <= kBHLeafSize || level >= kBHMaxLevel) {
+        nd.leaf = true;
+        float sx = 0.f, sy = 0.f;
+        for (int k = b; k < e; k++) { sx += T.px[k]; sy += T.py[k]; }
+        nd.mass = satMass * float(e - b);
+        nd.cx = sx / float(e - b); nd.cy = sy / float(e - b);
+    } else {
+        const int shift = 2 * (kBHMaxLevel - 1 - level);
+        float m = 0.f, mx = 0.f, my = 0.f;
+        int cb = b;
+        for (int q = 0; q < 4; q++) {
+            // Las claves están ordenadas: el cuadrante q es un subrango contiguo
+            const Uint32* first = &T.codes[cb];
+            const Uint32* last  = &T.codes[0] + e;
+            int ce = int(std::partition_point(first, last, [&](Uint32 c){ return int((c >> shift) & 3u) <= q; }) - &T.codes[0]);
+            if (ce > cb) {
+                int c = bhBuild(T, cb, ce, level + 1, rootSize, satMass, out);
+                nd.child[q] = c;
+                m  += out[c].mass;
+                mx += out[c].mass * out[c].cx;
+                my += out[c].mass * out[c].cy;
+            }
+            cb = ce;
         }
-        drawMenu(ren, P);
-        SDL_Delay(16);
+        nd.mass = m;
+        nd.cx = mx / m; nd.cy = my / m;
     }
+    out[id] = nd;
+    return id;
 }
 
-// ---------------- CLI args ----------------
-static void parseArgs(int argc, char** argv, SimParams& P) {
-    for (int i=1;i<argc;++i){
-        std::string a(argv[i]);
-        if (startsWith(a,"--N="))              P.N = std::max(0, toInt(a.substr(4), P.N));
-        else if (startsWith(a,"--G="))         P.G = std::max(0.f, toFloat(a.substr(4), P.G));
-        else if (startsWith(a,"--width="))     P.width  = std::max(640, toInt(a.substr(8), P.width));
-        else if (startsWith(a,"--height="))    P.height = std::max(480, toInt(a.substr(9), P.height));
-        else if (startsWith(a,"--massA="))     P.mainMassA = std::max(1.f, toFloat(a.substr(8), P.mainMassA));
-        else if (startsWith(a,"--massB="))     P.mainMassB = std::max(1.f, toFloat(a.substr(8), P.mainMassB));
-        else if (startsWith(a,"--radiusA="))   P.mainRadiusA = std::max(2.f, toFloat(a.substr(10), P.mainRadiusA));
-        else if (startsWith(a,"--radiusB="))   P.mainRadiusB = std::max(2.f, toFloat(a.substr(10), P.mainRadiusB));
-        else if (startsWith(a,"--mainInit="))  P.mainInitSpeed = std::max(0.f, toFloat(a.substr(11), P.mainInitSpeed));
-        else if (startsWith(a,"--eject="))     P.ejectSpeed = std::max(0.f, toFloat(a.substr(8), P.ejectSpeed));
-        else if (startsWith(a,"--satRadius=")) P.satRadius = std::max(1.f, toFloat(a.substr(12), P.satRadius));
-        else if (startsWith(a,"--satMass="))   P.satMass   = std::max(0.1f, toFloat(a.substr(10), P.satMass));
-        else if (startsWith(a,"--signA="))     P.mainSignA = clampf(toFloat(a.substr(8), P.mainSignA), -1.f, +1.f);
-        else if (startsWith(a,"--signB="))     P.mainSignB = clampf(toFloat(a.substr(8), P.mainSignB), -1.f, +1.f);
-        else if (a == "--benchmark")  P.benchmark = true;
-        else if (startsWith(a,"--frames=")) P.benchmarkFrames = std::max(1, toInt(a.substr(9), P.benchmarkFrames));
-        else std::cerr << "[warn] Arg no reconocido: " << a << "\n";
+// Niveles superiores (< kBHTopLevel): los hijos en el nivel kBHTopLevel son
+// placeholders -(celda+2) que se resuelven al concatenar los subárboles.
+static int bhBuildTop(std::vector<BHNode>& top, const std::vector<int>& cellBegin, int cell, int level, float rootSize) {
+    const int id = (int)top.size();
+    top.emplace_back();
+    BHNode nd;
+    nd.size = rootSize / float(1 << level);
+    const int span = 1 << (2 * (kBHTopLevel - level)); // celdas del nivel top bajo este nodo
+    nd.begin = cellBegin[cell]; nd.end = cellBegin[cell + span];
+    const int childSpan = span / 4;
+    for (int q = 0; q < 4; q++) {
+        int c0 = cell + q * childSpan;
+        if (cellBegin[c0] == cellBegin[c0 + childSpan]) continue;
+        nd.child[q] = (level + 1 == kBHTopLevel) ? -(c0 + 2) : bhBuildTop(top, cellBegin, c0, level + 1, rootSize);
+    }
+    top[id] = nd;
+    return id;
+}
+
+// Masa y centro de masa de los nodos top (índices < topCount), de abajo hacia arriba
+static void bhFinalizeTop(std::vector<BHNode>& nodes, int id, int topCount) {
+    BHNode& nd = nodes[id];
+    float m = 0.f, mx = 0.f, my = 0.f;
+    for (int q = 0; q < 4; q++) {
+        int c = nd.child[q];
+        if (c < 0) continue;
+        if (c < topCount) bhFinalizeTop(nodes, c, topCount);
+        m  += nodes[c].mass;
+        mx += nodes[c].mass * nodes[c].cx;
+        my += nodes[c].mass * nodes[c].cy;
+    }
+    nd.mass = m;
+    if (m > 0.f) { nd.cx = mx / m; nd.cy = my / m; }
+}
+
+static void bhBuildTree(BarnesHut& T, const SatArray& sat, const SimParams& p) {
+    const int n = (int)sat.size();
+    const float invW = 1.f / float(p.width), invH = 1.f / float(p.height);
+    const float rootSize = float(std::max(p.width, p.height));
+
+    T.codes.resize(n); T.order.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        T.codes[i] = mortonCode(sat.x[i], sat.y[i], invW, invH);
+        T.order[i] = (Uint32)i;
+    }
+    radixSortPairs(T.codes, T.order, T.tmpK, T.tmpV);
+
+    T.px.resize(n); T.py.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < n; k++) { T.px[k] = sat.x[T.order[k]]; T.py[k] = sat.y[T.order[k]]; }
+
+    // Celdas del nivel top: rango de cada una por búsqueda binaria sobre los bits altos
+    const int nCells = 1 << (2 * kBHTopLevel);
+    const int cellShift = 32 - 2 * kBHTopLevel;
+    std::vector<int> cellBegin(nCells + 1);
+    for (int c = 0; c <= nCells; c++) {
+        cellBegin[c] = (c == nCells) ? n : int(std::lower_bound(T.codes.begin(), T.codes.end(), Uint32(c) << cellShift) - T.codes.begin());
+    }
+
+    T.sub.resize(nCells);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < nCells; c++) {
+        T.sub[c].clear();
+        if (cellBegin[c] < cellBegin[c + 1])
+            bhBuild(T, cellBegin[c], cellBegin[c + 1], kBHTopLevel, rootSize, sat.mass, T.sub[c]);
+    }
+
+    // Concatenar: [nodos top][sub 0][sub 1]... y rebasar índices de hijos
+    T.nodes.clear();
+    if (n == 0) return;
+    bhBuildTop(T.nodes, cellBegin, 0, 0, rootSize);
+    const int topCount = (int)T.nodes.size();
+    std::vector<int> base(nCells + 1);
+    base[0] = topCount;
+    for (int c = 0; c < nCells; c++) base[c + 1] = base[c] + (int)T.sub[c].size();
+    T.nodes.resize(base[nCells]);
+
+    for (int k = 0; k < topCount; k++)
+        for (int q = 0; q < 4; q++)
+            if (T.nodes[k].child[q] <= -2) T.nodes[k].child[q] = base[-T.nodes[k].child[q] - 2];
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < nCells; c++) {
+        const int off = base[c];
+        for (std::size_t k = 0; k < T.sub[c].size(); k++) {
+            BHNode nd = T.sub[c][k];
+            for (int q = 0; q < 4; q++) if (nd.child[q] >= 0) nd.child[q] += off;
+            T.nodes[off + k] = nd;
+        }
+    }
+    bhFinalizeTop(T.nodes, 0, topCount);
+}
+
+// Recorrido por grupos: cada hoja arma UNA lista de interacción (celdas lejanas
+// aceptadas contra la caja de la hoja + satélites de hojas cercanas) y la
+// reutiliza para todos sus satélites; el loop interno es contiguo y vectorizable.
+// Suma G*satMass (siempre atractiva) y la aplica a vx/vy.
+static void bhApplySelfGravity(BarnesHut& T, SatArray& sat, const SimParams& p, float dt) {
+    const int n = (int)sat.size();
+    if (n == 0 || T.nodes.empty()) return;
+    const float theta2 = p.theta * p.theta;
+    const float soft2  = std::max(p.softening * p.softening, 1e-6f); // el propio satélite aporta 0
+    const float G = p.G;
+
+    T.leaves.clear();
+    for (int k = 0; k < (int)T.nodes.size(); k++) if (T.nodes[k].leaf) T.leaves.push_back(k);
+    const int nLeaves = (int)T.leaves.size();
+
+    #pragma omp parallel
+    {
+        std::vector<float> lx, ly, lm; // lista de interacción del hilo (SoA)
+        int stack[4 * kBHMaxLevel + 8];
+
+        #pragma omp for schedule(dynamic, 4)
+        for (int li = 0; li < nLeaves; li++) {
+            const BHNode& L = T.nodes[T.leaves[li]];
+            float minX = T.px[L.begin], maxX = minX, minY = T.py[L.begin], maxY = minY;
+            for (int k = L.begin + 1; k < L.end; k++) {
+                minX = std::min(minX, T.px[k]); maxX = std::max(maxX, T.px[k]);
+                minY = std::min(minY, T.py[k]); maxY = std::max(maxY, T.py[k]);
+            }
+
+            lx.clear(); ly.clear(); lm.clear();
+            int sp = 0;
+            stack[sp++] = 0;
+            while (sp > 0) {
+                const BHNode& nd = T.nodes[stack[--sp]];
+                // Distancia mínima del centro de masa de la celda a la caja de la hoja.
+                // Se suma el softening: celdas más chicas que theta*softening siempre
+                // se aproximan, así los cúmulos casi puntuales no degeneran en O(n^2).
+                float ddx = std::max(0.f, std::max(minX - nd.cx, nd.cx - maxX));
+                float ddy = std::max(0.f, std::max(minY - nd.cy, nd.cy - maxY));
+                if (nd.size * nd.size < theta2 * (ddx*ddx + ddy*ddy + soft2)) {
+                    lx.push_back(nd.cx); ly.push_back(nd.cy); lm.push_back(nd.mass);
+                } else if (nd.leaf) {
+                    for (int j = nd.begin; j < nd.end; j++) { lx.push_back(T.px[j]); ly.push_back(T.py[j]); lm.push_back(sat.mass); }
+                } else {
+                    for (int q = 0; q < 4; q++) if (nd.child[q] >= 0) stack[sp++] = nd.child[q];
+                }
+            }
+
+            const int m = (int)lx.size();
+            const float* sx = lx.data(); const float* sy = ly.data(); const float* sm = lm.data();
+            for (int k = L.begin; k < L.end; k++) {
+                const float x = T.px[k], y = T.py[k];
+                float ax = 0.f, ay = 0.f;
+                #pragma omp simd reduction(+:ax,ay)
+                for (int j = 0; j < m; j++) {
+                    float ex = sx[j] - x, ey = sy[j] - y;
+                    float invr = 1.0f / std::sqrt(ex*ex + ey*ey + soft2);
+                    float s = sm[j] * invr * invr * invr;
+                    ax += s * ex; ay += s * ey;
+                }
+                const Uint32 i = T.order[k];
+                sat.vx[i] += G * ax * dt;
+                sat.vy[i] += G * ay * dt;
+            }
+        }
+    }
+}
+
+// ---------------- Colisiones satélite-satélite (grilla uniforme) ----------------
+// Grilla con celdas de lado 2*radio: cada par en contacto está en celdas vecinas (3x3).
+// Cada frame: id de celda por satélite -> ordenamiento por conteo paralelo
+// (radixSortPairs, estable) -> rangos por celda. La resolución es en dos fases
+// sin locks: cada satélite JUNTA (gather) la corrección de todos sus vecinos
+// leyendo el estado anterior y escribe solo su propio resultado.
+struct SatGrid {
+    int gx = 0, gy = 0;
+    float cell = 1.f;
+    AlignedVec<Uint32> keys, order, tmpK, tmpV;
+    AlignedVec<Uint32> cellStart, cellEnd;
+    AlignedVec<float> sx, sy, svx, svy;   // estado en orden de celda
+    double buildMs = 0.0, resolveMs = 0.0; // acumulados (para el benchmark)
+    int frames = 0;
+};
+static SatGrid gGrid;
+
+static void gridBuild(SatGrid& G, const SatArray& sat, const SimParams& p) {
+    const int n = (int)sat.size();
+    G.cell = std::max(1.f, 2.f * sat.radius);
+    G.gx = std::max(1, (int)std::ceil(p.width  / G.cell));
+    G.gy = std::max(1, (int)std::ceil(p.height / G.cell));
+    const int nCells = G.gx * G.gy;
+    const float inv = 1.f / G.cell;
+
+    G.keys.resize(n); G.order.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        int cx = std::min(G.gx - 1, std::max(0, (int)(sat.x[i] * inv)));
+        int cy = std::min(G.gy - 1, std::max(0, (int)(sat.y[i] * inv)));
+        G.keys[i]  = Uint32(cy * G.gx + cx);
+        G.order[i] = Uint32(i);
+    }
+    radixSortPairs(G.keys, G.order, G.tmpK, G.tmpV);
+
+    G.cellStart.assign(nCells, 0u);
+    G.cellEnd.assign(nCells, 0u);
+    G.sx.resize(n); G.sy.resize(n); G.svx.resize(n); G.svy.resize(n);
+    #pragma omp parallel for schedule(static)
+    for (int k = 0; k < n; k++) {
+        const Uint32 key = G.keys[k];
+        if (k == 0     || G.keys[k - 1] != key) G.cellStart[key] = Uint32(k);
+        if (k == n - 1 || G.keys[k + 1] != key) G.cellEnd[key]   = Uint32(k + 1);
+        const Uint32 i = G.order[k];
+        G.sx[k] = sat.x[i];   G.sy[k] = sat.y[i];
+        G.svx[k] = sat.vx[i]; G.svy[k] = sat.vy[i];
+    }
+}
+
+// Contacto entre satélites de igual masa: separación mitad y mitad + impulso
+// con restitución p.satRestitution (mismo esquema que resolveElasticCollision);
+// el impulso se promedia sobre los contactos de cada satélite
+static void gridResolve(SatGrid& G, SatArray& sat, const SimParams& p) {
+    const float minDist = 2.f * sat.radius;
+    const float minDist2 = minDist * minDist;
+    const float e = p.satRestitution;
+
+    parallelFor(p.backend, G.gx * G.gy, 64, [&](int c0, int c1) {
+    for (int c = c0; c < c1; c++) {
+        const int cx = c % G.gx, cy = c / G.gx;
+        for (Uint32 k = G.cellStart[c]; k < G.cellEnd[c]; k++) {
+            const float x = G.sx[k], y = G.sy[k];
+            const float vx = G.svx[k], vy = G.svy[k];
+            float px = 0.f, py = 0.f, dvx = 0.f, dvy = 0.f;
+            int contacts = 0;
+            for (int ny = std::max(0, cy - 1); ny <= std::min(G.gy - 1, cy + 1); ny++) {
+                for (int nx = std::max(0, cx - 1); nx <= std::min(G.gx - 1, cx + 1); nx++) {
+                    const int nc = ny * G.gx + nx;
+                    for (Uint32 j = G.cellStart[nc]; j < G.cellEnd[nc]; j++) {
+                        if (j == k) continue;
+                        float dx = G.sx[j] - x, dy = G.sy[j] - y;   // de k hacia j
+                        float dist2 = dx*dx + dy*dy;
+                        if (dist2 >= minDist2) continue;
+                        float dist, nxn, nyn;
+                        if (dist2 > 0.0001f) {
+                            dist = std::sqrt(dist2);
+                            nxn = dx / dist; nyn = dy / dist;
+                        } else {
+                            // Superpuestos (p.ej. apilados contra una pared): dirección
+                            // pseudoaleatoria por par, opuesta para cada lado
+                            Uint32 lo = std::min(G.order[k], G.order[j]), hi = std::max(G.order[k], G.order[j]);
+                            float ang = float((lo * 2654435761u) ^ (hi * 40503u)) * (6.2831853f / 4294967296.f);
+                            float sgn = (G.order[k] == lo) ? 1.f : -1.f;
+                            dist = 0.f;
+                            nxn = sgn * std::cos(ang); nyn = sgn * std::sin(ang);
+                        }
+                        float overlap = 0.5f * (minDist - dist);
+                        px -= nxn * overlap; py -= nyn * overlap;
+                        contacts++;
+
+                        float relVel = (G.svx[j] - vx) * nxn + (G.svy[j] - vy) * nyn;
+                        if (relVel > 0) continue; // ya se separan
+                        float jimp = 0.5f * (1.f + e) * relVel; // masas iguales: j/m
+                        dvx += jimp * nxn; dvy += jimp * nyn;
+                    }
+                }
+            }
+            // Impulso promediado por contacto (Jacobi): con muchos vecinos la suma
+            // directa sobrecorrige y las velocidades divergen
+            if (contacts > 1) {
+                float inv = 1.f / float(contacts);
+                dvx *= inv; dvy *= inv;
+            }
+            const Uint32 i = G.order[k];
+            sat.x[i]  = x + px;   sat.y[i]  = y + py;
+            sat.vx[i] = vx + dvx; sat.vy[i] = vy + dvy;
+        }
     }
+    });
 }
 
 // ---------------- Lógica de simulación ----------------
+static constexpr int kSatGrain = 2048;   // múltiplo de 16 para el kernel SIMD
+
+// Trae a caché el primer bloque de satélites [begin, end) antes de que arranque el kernel
+static void prefetchSats(const SatArray& sat, int begin, int end) {
+#ifdef __GNUC__
+    constexpr int kLine = 64 / sizeof(float);
+    for (int i = begin; i < end; i += kLine) {
+        __builtin_prefetch(&sat.x[i]);  __builtin_prefetch(&sat.y[i]);
+        __builtin_prefetch(&sat.vx[i]); __builtin_prefetch(&sat.vy[i]);
+        __builtin_prefetch(&sat.cooldown[i]);
+    }
+#else
+    (void)sat; (void)begin; (void)end;
+#endif
+}
+
 static void step(SimState& S, const SimParams& p, float dt) {
     // Principales: mover + paredes + amortiguación
     auto moveMain = [&](Body& M){
@@ -476,48 +3559,734 @@ static void step(SimState& S, const SimParams& p, float dt) {
         M.vy *= p.mainDamping;
     };
 
-    moveMain(S.mainA);
-    moveMain(S.mainB);
-    moveMain(S.mainA2);
-    moveMain(S.mainB2);
+    // Auto-gravedad entre satélites (Barnes-Hut), antes del kernel de principales.
+    // Solo toca satélites, así que puede ir antes de mover los principales.
+    // Barnes-Hut y las colisiones trabajan sobre SatArray: con --compact no corren.
+    const bool compact = S.compact.bits != 0;
+    if (p.selfGravity && !compact) {
+        double t0 = omp_get_wtime();
+        bhBuildTree(gBH, S.sats, p);
+        double t1 = omp_get_wtime();
+        bhApplySelfGravity(gBH, S.sats, p, dt);
+        double t2 = omp_get_wtime();
+        gBH.buildMs += (t1 - t0) * 1000.0;
+        gBH.walkMs  += (t2 - t1) * 1000.0;
+        gBH.frames++;
+    }
+
+    // Una sola región por paso: el hilo 0 hace la parte serial de los principales
+    // mientras los demás precargan su primer bloque de satélites; una barrera y
+    // después todos corren el kernel (bloques múltiplos de 16 para el SIMD).
+    SatArray& sat = S.sats;
+    const int n = compact ? (int)S.compact.size() : (int)sat.size();
+    const SatKernelFn kernel = satKernelFor(p.simd);
+    const CompactKernelFn compactKernel = compactKernelFor(S.compact.bits, p.simd);
+    parallelRegion(p.backend, [&](const Team& t) {
+        if (t.tid == 0) {
+            for (Body& M : S.mains) moveMain(M);
+
+            // Todos los pares (i<j), en el mismo orden que el caso clásico de 4 principales
+            const int nm = (int)S.mains.size();
+            for (int i = 0; i < nm; i++)
+                for (int j = i + 1; j < nm; j++)
+                    resolveElasticCollision(S.mains[i], S.mains[j]);
+
+            packMains(S, p);
+        } else {
+            int k0, k1;
+            teamBlocks(t, (n + kSatGrain - 1) / kSatGrain, k0, k1);
+            if (k0 < k1 && !compact) prefetchSats(sat, k0 * kSatGrain, std::min(n, (k0 + 1) * kSatGrain));
+        }
+        teamBarrier(t);   // mainsSoA listo para todos
+        teamFor(t, n, kSatGrain, [&](int begin, int end) {
+            if (compact) compactKernel(S.compact, begin, end, S, p, dt);
+            else         kernel(sat, begin, end, S, p, dt);
+        });
+    });
+
+    // Colisiones entre satélites (después de integrar)
+    if (p.satCollisions && !compact) {
+        double t0 = omp_get_wtime();
+        gridBuild(gGrid, sat, p);
+        double t1 = omp_get_wtime();
+        gridResolve(gGrid, sat, p);
+        double t2 = omp_get_wtime();
+        gGrid.buildMs   += (t1 - t0) * 1000.0;
+        gGrid.resolveMs += (t2 - t1) * 1000.0;
+        gGrid.frames++;
+    }
+}
+
+// ---------------- Pipeline simulación / render ----------------
+// Un hilo dueño de SimState ejecuta los pasos fijos y copia el resultado a un
+// frame "trasero"; el hilo principal dibuja el frame "delantero" mientras tanto.
+// El traspaso es por dos contadores atómicos (posted/done): el principal solo
+// cambia de frame cuando done == posted, así que nunca hay dos hilos sobre el
+// mismo buffer y no hace falta mutex.
+struct PipeFrame {
+    AlignedVec<float> x, y;
+    AlignedVec<Uint32> color;
+    AlignedVec<Uint8> qx, qy, colorIdx;   // --compact: columnas cuantizadas tal cual
+    Uint32 palette[256] = {};
+    int qbits = 0, n = 0;
+    float fromX = 1.f, fromY = 1.f;
+    std::vector<Body> mains;
+    float radius = 1.f;
+    Interpolator interp;   // posiciones del paso anterior (prev) + scratch de dibujo
+
+    void capture(const SimState& S) {
+        const DrawView v = viewOf(S);
+        qbits = v.qbits; n = v.n;
+        if (v.qbits) {   // con --compact se copia el punto fijo, sin decodificar
+            const Uint8* sx = static_cast<const Uint8*>(v.qx);
+            const Uint8* sy = static_cast<const Uint8*>(v.qy);
+            qx.assign(sx, sx + v.qbytes()); qy.assign(sy, sy + v.qbytes());
+            colorIdx.assign(v.colorIdx, v.colorIdx + v.n);
+            std::memcpy(palette, v.palette, sizeof palette);
+            fromX = v.fromX; fromY = v.fromY;
+        } else {
+            x.assign(v.x, v.x + v.n); y.assign(v.y, v.y + v.n); color.assign(v.color, v.color + v.n);
+        }
+        mains = S.mains;
+        radius = v.radius;
+    }
+    DrawView view() const {
+        DrawView v;
+        if (qbits) {
+            v.qbits = qbits; v.qx = qx.data(); v.qy = qy.data();
+            v.fromX = fromX; v.fromY = fromY;
+            v.colorIdx = colorIdx.data(); v.palette = palette;
+        } else {
+            v.x = x.data(); v.y = y.data(); v.color = color.data();
+        }
+        v.n = n; v.radius = radius;
+        v.mains = &mains;
+        return v;
+    }
+};
+
+struct SimPipeline {
+    SimState* S = nullptr;
+    const SimParams* P = nullptr;
+    PipeFrame frames[2];
+    int front = 0;                 // solo lo cambia el hilo principal, con el worker ocioso
+    bool pending = false;          // hay un trabajo publicado cuyo resultado no se tomó
+    int jobSubsteps = 0;           // trabajo pendiente (se publica con 'posted')
+    bool jobReset = false;
+    int renderThreads = 1, simThreads = 1;
+    omp_sched_t schedKind = omp_sched_static;   // el hilo nuevo no hereda omp_set_schedule
+    int schedChunk = 0;
+    double simMs = 0.0;            // tiempo de step() acumulado en el worker
+    std::atomic<int> posted{0}, done{0};
+    std::atomic<bool> quit{false};
+    std::thread worker;
+};
+
+static void pipeWorker(SimPipeline& pl) {
+    omp_set_num_threads(pl.simThreads);   // ICV por hilo: no afecta al raster
+    omp_set_schedule(pl.schedKind, pl.schedChunk);
+    SimState& S = *pl.S;
+    const SimParams& P = *pl.P;
+    const float h = 1.f / P.simHz;
+    int seen = 0;
+    for (;;) {
+        int seq;
+        while ((seq = pl.posted.load(std::memory_order_acquire)) == seen) {
+            if (pl.quit.load(std::memory_order_acquire)) return;
+            std::this_thread::yield();
+        }
+        seen = seq;
+
+        PipeFrame& back = pl.frames[pl.front ^ 1];
+        double t0 = omp_get_wtime();
+        if (pl.jobReset) { startSim(S, P); back.interp.snapshot(S); }
+        for (int k = 0; k < pl.jobSubsteps; k++) {
+            if (reorderDue(P)) reorderSats(S.sats, P);   // su tiempo queda en pl.simMs
+            if (k == pl.jobSubsteps - 1 && P.interpolate) back.interp.snapshot(S);
+            step(S, P, h);
+            trajAfterStep(gTraj, S, P);
+        }
+        back.capture(S);
+        pl.simMs += (omp_get_wtime() - t0) * 1000.0;
+        pl.done.store(seq, std::memory_order_release);
+    }
+}
+
+// S ya inicializado; a partir de acá solo el worker lo toca hasta pipeStop()
+static void pipeStart(SimPipeline& pl, SimState& S, const SimParams& P) {
+    pl.S = &S; pl.P = &P;
+    const int total = omp_get_max_threads();
+    pl.renderThreads = std::max(1, total / 4);
+    pl.simThreads = std::max(1, total - pl.renderThreads);
+    omp_get_schedule(&pl.schedKind, &pl.schedChunk);
+    for (PipeFrame& F : pl.frames) { F.capture(S); F.interp.snapshot(S); }
+    pl.front = 0;
+    omp_set_num_threads(pl.renderThreads);
+    pl.worker = std::thread(pipeWorker, std::ref(pl));
+}
+
+// Si el trabajo en curso terminó (o block=true y se espera), su frame pasa adelante
+static void pipeCollect(SimPipeline& pl, bool block) {
+    if (!pl.pending) return;
+    const int seq = pl.posted.load(std::memory_order_relaxed);
+    if (!block && pl.done.load(std::memory_order_acquire) != seq) return;
+    while (pl.done.load(std::memory_order_acquire) != seq) std::this_thread::yield();
+    pl.front ^= 1;
+    pl.pending = false;
+}
+
+static void pipePost(SimPipeline& pl, int substeps, bool reset) {
+    pipeCollect(pl, true);
+    pl.jobSubsteps = substeps;
+    pl.jobReset = reset;
+    pl.pending = true;
+    pl.posted.store(pl.posted.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+static void pipeStop(SimPipeline& pl) {
+    pipeCollect(pl, true);
+    pl.quit.store(true, std::memory_order_release);
+    if (pl.worker.joinable()) pl.worker.join();
+    omp_set_num_threads(pl.renderThreads + pl.simThreads);
+}
+
+// ---------------- Benchmark sin ventana ----------------
+// Desglose de las fases opcionales (Barnes-Hut, colisiones)
+static void printOptionalStats(const SimParams& P) {
+    if (P.selfGravity && gBH.frames > 0) {
+        std::cout << "[Benchmark] Barnes-Hut theta=" << P.theta
+                  << "  build: " << (gBH.buildMs / gBH.frames) << " ms/frame"
+                  << "  traversal: " << (gBH.walkMs / gBH.frames) << " ms/frame"
+                  << "  nodos: " << gBH.nodes.size() << "\n";
+    }
+    if (P.satCollisions && gGrid.frames > 0) {
+        std::cout << "[Benchmark] Colisiones grilla " << gGrid.gx << "x" << gGrid.gy
+                  << "  build: " << (gGrid.buildMs / gGrid.frames) << " ms/frame"
+                  << "  resolve: " << (gGrid.resolveMs / gGrid.frames) << " ms/frame\n";
+    }
+    if (P.reorderEvery > 0 && gReorder.count > 0) {
+        std::cout << "[Benchmark] Reorden Morton cada " << P.reorderEvery << " pasos: "
+                  << gReorder.count << " veces, " << (gReorder.ms / gReorder.count) << " ms c/u\n";
+    }
+}
 
-    resolveElasticCollision(S.mainA,  S.mainB);
-    resolveElasticCollision(S.mainA,  S.mainA2);
-    resolveElasticCollision(S.mainA,  S.mainB2);
-    resolveElasticCollision(S.mainB,  S.mainA2);
-    resolveElasticCollision(S.mainB,  S.mainB2);
-    resolveElasticCollision(S.mainA2, S.mainB2);
+// SIM/RASTER: no toca SDL en absoluto (sirve en servidores sin display)
+static const char* benchModeLabel(BenchMode m) {
+    switch (m) {
+        case BenchMode::SIM:    return "sim";
+        case BenchMode::RASTER: return "raster";
+        default:                return "full";
+    }
+}
+
+// Resultado en una sola línea para herramientas (bench_runner): BENCH_JSON {...}
+static void printBenchJson(const SimParams& P, const char* mode, double totalMs, double stepMs, double rasterMs) {
+    omp_sched_t kind; int chunk;
+    omp_get_schedule(&kind, &chunk);
+    const char* sched = (kind == omp_sched_static) ? "static" : (kind == omp_sched_dynamic) ? "dynamic"
+                      : (kind == omp_sched_guided) ? "guided" : "auto";
+    TeleStats fr = teleStats(gTele, TP_FRAME);
+    std::cout << "BENCH_JSON {\"backend\":\"" << backendLabel(P.backend) << "\",\"mode\":\"" << mode << (P.pipeline ? "+pipeline" : "")
+              << "\",\"simd\":\"" << simdLabel(P.simd) << "\",\"render\":\"" << renderModeLabel(P.renderMode)
+              << "\",\"compact\":" << P.compactBits << ",\"threads\":" << omp_get_max_threads()
+              << ",\"schedule\":\"" << sched << "\",\"chunk\":" << chunk
+              << ",\"N\":" << P.N << ",\"width\":" << P.width << ",\"height\":" << P.height
+              << ",\"frames\":" << P.benchmarkFrames << ",\"seed\":" << P.seed
+              << ",\"total_ms\":" << totalMs << ",\"avg_ms\":" << (totalMs / P.benchmarkFrames)
+              << ",\"step_ms\":" << stepMs << ",\"raster_ms\":" << rasterMs
+              << ",\"p50_ms\":" << fr.p50 << ",\"p95_ms\":" << fr.p95 << ",\"p99_ms\":" << fr.p99
+              << ",\"max_ms\":" << fr.max << "}\n";
+}
+
+// Error de --compact contra el camino en float (--compact-report). Los dos arrancan
+// del mismo estado (el compacto decodificado) y usan el mismo nivel SIMD, así la
+// diferencia es solo la cuantización: tras un paso es el error por paso y después
+// se le suma la divergencia propia de la dinámica, que es caótica cerca de los
+// principales. Para separar una cosa de la otra se corre además un tercer estado
+// en float con las posiciones movidas 1 ulp: esa fila es el piso de divergencia
+// de cualquier diferencia de redondeo. Necesita memoria para los tres estados.
+struct CompactError { double maxPos = 0, rmsPos = 0, maxVel = 0, rmsVel = 0, far = 0; };
+
+static CompactError satError(const SatArray& F, const float* x, const float* y,
+                             const float* vx, const float* vy, int n) {
+    double maxP = 0, sumP = 0, maxV = 0, sumV = 0, far = 0;
+    #pragma omp parallel for schedule(static) reduction(max:maxP,maxV) reduction(+:sumP,sumV,far)
+    for (int i = 0; i < n; i++) {
+        const double dx = double(x[i]) - F.x[i], dy = double(y[i]) - F.y[i];
+        const double dvx = double(vx[i]) - F.vx[i], dvy = double(vy[i]) - F.vy[i];
+        const double dp = std::sqrt(dx*dx + dy*dy), dv = std::sqrt(dvx*dvx + dvy*dvy);
+        maxP = std::max(maxP, dp); sumP += dp * dp;
+        maxV = std::max(maxV, dv); sumV += dv * dv;
+        if (dp > 1.0) far += 1.0;
+    }
+    CompactError e;
+    e.maxPos = maxP; e.maxVel = maxV;
+    if (n > 0) { e.rmsPos = std::sqrt(sumP / n); e.rmsVel = std::sqrt(sumV / n); e.far = 100.0 * far / n; }
+    return e;
+}
 
-    // Satélites (PARALELIZADOS)
+// Decodifica C completo (posiciones, velocidades y cooldown) sobre las columnas de out
+static void compactDecodeInto(const SimState& C, SatArray& out) {
+    const CompactSats& c = C.compact;
+    const DrawView v = viewOf(C);
+    out.resize(v.n);
     #pragma omp parallel for schedule(static)
-    for (int i = 0; i < (int)S.sats.size(); i++) {
-        Body& s = S.sats[i];
-        if (s.eject_cooldown > 0.f)
-            s.eject_cooldown = std::max(0.f, s.eject_cooldown - dt);
+    for (int i = 0; i < v.n; i++) {
+        v.pos(i, out.x[i], out.y[i]);
+        out.vx[i] = halfToFloat(c.vx[i]); out.vy[i] = halfToFloat(c.vy[i]);
+        out.cooldown[i] = float(c.cooldown[i]) * c.cdFromQ;
+        out.color[i] = v.colorAt(i);
+    }
+}
+
+static void printCompactError(const std::string& label, const char* what, const CompactError& e) {
+    std::cout << "[Compact] " << std::left << std::setw(10) << label << std::setw(8) << what << std::right
+              << "pos max: " << e.maxPos << "  rms: " << e.rmsPos << " px"
+              << "   vel max: " << e.maxVel << "  rms: " << e.rmsVel << " px/s"
+              << "   >1 px: " << e.far << "%\n";
+}
+
+static void printCompactReport(const SimParams& P) {
+    SimParams pf = P;
+    pf.compactBits = 0;
+    SimState F, C, U;
+    initSim(F, pf);
+    initSim(C, P);
+    std::cout << "[Compact] " << P.compactBits << " bits: " << C.compact.bytesPerSat()
+              << " B/satélite (float: " << 6 * sizeof(float) << ")  resolución x: "
+              << C.compact.fromX << " px\n";
+    SatArray dec;
+    compactDecodeInto(C, dec);
+    const int n = (int)dec.size();
+    printCompactError("inicio", "compact", satError(F.sats, dec.x.data(), dec.y.data(), dec.vx.data(), dec.vy.data(), n));
+
+    // La referencia arranca de lo mismo que ve el kernel compacto; U, 1 ulp corrida
+    dec.radius = F.sats.radius; dec.mass = F.sats.mass;
+    F.sats = dec;
+    U = F;
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        U.sats.x[i] = std::nextafter(U.sats.x[i], 1e9f);
+        U.sats.y[i] = std::nextafter(U.sats.y[i], 1e9f);
+    }
+
+    const float dt = 1.f / P.simHz;
+    int next = 1;
+    for (int k = 1; k <= P.benchmarkFrames; k++) {
+        step(F, pf, dt);
+        step(U, pf, dt);
+        step(C, P, dt);
+        if (k == next || k == P.benchmarkFrames) {
+            const std::string label = "paso " + std::to_string(k);
+            compactDecodeInto(C, dec);
+            const SatArray& u = U.sats;
+            printCompactError(label, "compact", satError(F.sats, dec.x.data(), dec.y.data(), dec.vx.data(), dec.vy.data(), n));
+            printCompactError("", "1 ulp", satError(F.sats, u.x.data(), u.y.data(), u.vx.data(), u.vy.data(), n));
+            while (next <= k) next *= 10;
+        }
+    }
+}
+
+static int runHeadlessBenchmark(const SimParams& P) {
+    using clock = std::chrono::steady_clock;
+    SimState S;
+    startSim(S, P);
+
+    AlignedVec<Uint32> frame;
+    const bool raster = (P.benchMode == BenchMode::RASTER);
+    if (raster) frame.resize((size_t)P.width * (size_t)P.height);
+    const Uint32 bg = packRGBA(10, 14, 20, 255);
+    if (!P.trajOut.empty()) trajStart(gTraj, P.trajOut, P);
+    if (!P.recordOut.empty()) {
+        if (raster) recStart(gRec, P.recordOut, P.width, P.height, P.simHz);
+        else std::cerr << "[warn] --record necesita --bench-mode=raster o full (sim no dibuja)\n";
+    }
+
+    double simMs = 0.0, rasterMs = 0.0;
+    auto t0 = clock::now();
+    if (raster && P.pipeline) {
+        // step del frame f+1 en el worker mientras se rasteriza el f
+        SimPipeline pipe;
+        pipeStart(pipe, S, P);
+        for (int f = 0; f < P.benchmarkFrames; f++) {
+            teleBeginFrame(gTele);
+            pipePost(pipe, 1, false);
+            teleMark(gTele, TP_STEP);   // espera al worker
+            auto b = clock::now();
+            const PipeFrame& F = pipe.frames[pipe.front];
+            rasterLayer(frame.data(), F.view(), P, &bg);
+            rasterMs += std::chrono::duration<double, std::milli>(clock::now() - b).count();
+            teleMark(gTele, TP_RASTER);
+            if (!P.recordOut.empty()) {
+                recSubmit(gRec, frame.data(), &F.mains);
+                teleMark(gTele, TP_RECORD);
+            }
+            teleEndFrame(gTele);
+        }
+        pipeStop(pipe);
+        simMs = pipe.simMs;
+    }
+    else for (int f = 0; f < P.benchmarkFrames; f++) {
+        // paso fijo de la simulación (--simHz)
+        float dt = 1.f / P.simHz;
+        teleBeginFrame(gTele);
+        auto a = clock::now();
+        if (reorderDue(P)) { reorderSats(S.sats, P); teleMark(gTele, TP_REORDER); }
+        step(S, P, dt);
+        trajAfterStep(gTraj, S, P);
+        auto b = clock::now();
+        simMs += std::chrono::duration<double, std::milli>(b - a).count();
+        teleMark(gTele, TP_STEP);
+
+        if (raster) {
+            rasterLayer(frame.data(), viewOf(S), P, &bg);
+            rasterMs += std::chrono::duration<double, std::milli>(clock::now() - b).count();
+            teleMark(gTele, TP_RASTER);
+            if (!P.recordOut.empty()) {
+                recSubmit(gRec, frame.data(), &S.mains);
+                teleMark(gTele, TP_RECORD);
+            }
+        }
+        teleEndFrame(gTele);
+    }
+    double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+    recStop(gRec);
+    trajStop(gTraj);
+    if (!P.saveCheckpoint.empty()) saveCheckpoint(S, P, P.saveCheckpoint);
+
+    double satsPerSec = (ms > 0.0) ? double(P.N) * P.benchmarkFrames / (ms / 1000.0) : 0.0;
+    std::cout << "[Benchmark] Modo: " << benchModeLabel(P.benchMode) << (raster && P.pipeline ? "+pipeline" : "")
+              << "  Backend: " << backendLabel(P.backend) << "  SIMD: " << simdLabel(P.simd);
+    if (raster) std::cout << "  Render: " << renderModeLabel(P.renderMode);
+    std::cout << "  N: " << P.N << "  Seed: " << P.seed
+              << "  Frames: " << P.benchmarkFrames
+              << "  Tiempo total: " << ms << " ms"
+              << "  Avg por frame: " << (ms / P.benchmarkFrames) << " ms\n";
+    std::cout << "[Benchmark] step: " << (simMs / P.benchmarkFrames) << " ms/frame";
+    if (raster) std::cout << "  raster: " << (rasterMs / P.benchmarkFrames) << " ms/frame";
+    std::cout << "  Throughput: " << satsPerSec / 1e6 << " Msat/s\n";
+    if (P.compactBits)
+        std::cout << "[Benchmark] Satélites compactos " << P.compactBits << " bits: "
+                  << S.compact.bytesPerSat() << " B/satélite (float: " << 6 * sizeof(float) << ")\n";
+    printOptionalStats(P);
+    telePrint(gTele);
+    if (!P.telemetryOut.empty()) teleWriteFiles(gTele, P.telemetryOut);
+    if (P.benchJson) printBenchJson(P, benchModeLabel(P.benchMode), ms,
+                                    simMs / P.benchmarkFrames, rasterMs / P.benchmarkFrames);
+    if (P.compactReport) {
+        S = SimState();   // libera el estado medido antes de armar los dos del reporte
+        printCompactReport(P);
+    }
+    return 0;
+}
+
+// ---------------- Replay de trayectorias (--replay=) ----------------
+// Reproduce un archivo de --traj sin simular: se mapea en memoria, el índice del
+// final da el offset de cada frame (si falta, por ejemplo porque la corrida se
+// cortó, se arma recorriendo los bloques) y para ir al frame f se decodifica desde
+// el último keyframe <= f, o desde el actual si f está más adelante y no hay un
+// keyframe en el medio. Solo se decodifican x, y y las velocidades (para la
+// predicción); el cooldown se saltea. Las posiciones van directo a renderSim().
+struct TrajReader {
+    MappedFile file;
+    const TrajHeader* h = nullptr;
+    std::vector<TrajIndexEntry> index;
+    int current = -1;                   // frame cuyo estado está en q
+    std::vector<Sint32> q[kTjVY + 1];   // x, y, vx, vy cuantizados
+    AlignedVec<float> x, y;
+    AlignedVec<Uint32> color;
+    std::vector<Body> mains;
+};
+static TrajReader gReplay;
+
+static const TrajFrameHeader* trajFrameAt(const TrajReader& R, Uint64 off) {
+    if (off + sizeof(TrajFrameHeader) > R.file.size) return nullptr;
+    const TrajFrameHeader* fh = reinterpret_cast<const TrajFrameHeader*>(R.file.data + off);
+    if (fh->magic != kTrajFrameMagic) return nullptr;
+    Uint64 expect = fh->numMains * sizeof(TrajMain) + (fh->key ? Uint64(fh->n) * sizeof(Uint32) : 0);
+    for (int k = 0; k < kTjColumns; k++) expect += fh->colBytes[k];
+    if (expect != fh->payloadBytes || off + sizeof(TrajFrameHeader) + fh->payloadBytes > R.file.size) return nullptr;
+    return fh;
+}
+
+static bool trajOpen(TrajReader& R, const std::string& path) {
+    if (!mapFile(R.file, path)) { std::cerr << "No se pudo abrir " << path << "\n"; return false; }
+    auto fail = [&](const char* why) {
+        std::cerr << "Trayectoria " << path << " inválida: " << why << "\n";
+        unmapFile(R.file);
+        return false;
+    };
+    if (R.file.size < sizeof(TrajHeader)) return fail("archivo demasiado corto");
+    R.h = reinterpret_cast<const TrajHeader*>(R.file.data);
+    if (std::memcmp(R.h->magic, kTrajMagic, sizeof R.h->magic) != 0) return fail("no es un archivo de --traj");
+    if (R.h->version != kTrajVersion) return fail("versión no soportada");
+    if (R.h->endian != kCheckpointEndian || R.h->headerBytes != sizeof(TrajHeader)
+        || R.h->frameHeaderBytes != sizeof(TrajFrameHeader)) return fail("escrito con otro layout");
+
+    // Índice del final; si no está o no cierra, se recorren los bloques
+    R.index.clear();
+    const TrajFooter* ft = (R.file.size >= sizeof(TrajHeader) + sizeof(TrajFooter))
+        ? reinterpret_cast<const TrajFooter*>(R.file.data + R.file.size - sizeof(TrajFooter)) : nullptr;
+    if (ft && std::memcmp(ft->magic, kTrajIndexMagic, sizeof ft->magic) == 0
+        && ft->indexOffset + ft->frames * sizeof(TrajIndexEntry) + sizeof(TrajFooter) == R.file.size) {
+        const TrajIndexEntry* e = reinterpret_cast<const TrajIndexEntry*>(R.file.data + ft->indexOffset);
+        R.index.assign(e, e + ft->frames);
+    } else {
+        std::cerr << "[warn] " << path << " no tiene índice, se arma recorriendo los frames\n";
+        Uint64 off = sizeof(TrajHeader);
+        while (const TrajFrameHeader* fh = trajFrameAt(R, off)) {
+            R.index.push_back(TrajIndexEntry{ off, fh->step, fh->key, 0 });
+            off += sizeof(TrajFrameHeader) + fh->payloadBytes;
+        }
+    }
+    for (const TrajIndexEntry& e : R.index)
+        if (!trajFrameAt(R, e.offset)) return fail("frame fuera del archivo");
+    if (R.index.empty()) return fail("no tiene frames");
+    if (!R.index[0].key) return fail("el primer frame no es keyframe");
+    R.current = -1;
+    return true;
+}
 
-        applyGravityFromMains(s, S.mainA, S.mainB, S.mainA2, S.mainB2, p, dt);
+static void trajClose(TrajReader& R) {
+    unmapFile(R.file);
+    R.h = nullptr;
+    R.index.clear();
+    R.current = -1;
+}
+
+// Aplica los residuos de una columna sobre q (vel: velocidades del frame anterior, solo x e y)
+static bool trajDecodeColumn(const Uint8* p, const Uint8* end, Sint32* q, std::size_t n,
+                             const Sint32* vel, Sint32 advanceFx) {
+    for (std::size_t i = 0; i < n; i++) {
+        Uint32 z = 0;
+        int sh = 0;
+        Uint8 b;
+        do {
+            if (p == end || sh > 28) return false;
+            b = *p++;
+            z |= Uint32(b & 0x7F) << sh;
+            sh += 7;
+        } while (b & 0x80);
+        const Sint32 pred = vel ? trajPredict(q[i], vel[i], advanceFx) : q[i];
+        q[i] = Sint32(Uint32(pred) + Uint32(unzigzag(z)));
+    }
+    return true;
+}
+
+static bool trajDecodeFrame(TrajReader& R, int f) {
+    const TrajFrameHeader* fh = trajFrameAt(R, R.index[f].offset);
+    const std::size_t n = fh->n;
+    const Uint8* p = R.file.data + R.index[f].offset + sizeof(TrajFrameHeader);
+    const TrajMain* tm = reinterpret_cast<const TrajMain*>(p);
+    R.mains.assign(fh->numMains, Body{});
+    for (std::size_t k = 0; k < R.mains.size(); k++) {
+        Body& M = R.mains[k];
+        M.x = tm[k].x; M.y = tm[k].y; M.vx = tm[k].vx; M.vy = tm[k].vy; M.radius = tm[k].radius;
+        M.color = SDL_Color{ Uint8(tm[k].color >> 24), Uint8(tm[k].color >> 16), Uint8(tm[k].color >> 8), 255 };
+        M.is_main = true;
+    }
+    p += fh->numMains * sizeof(TrajMain);
+    if (fh->key) {
+        const Uint32* c = reinterpret_cast<const Uint32*>(p);
+        R.color.assign(c, c + n);
+        for (auto& col : R.q) col.assign(n, 0);
+        p += n * sizeof(Uint32);
+    } else if (R.q[0].size() != n) {
+        return false;
+    }
+    const Uint8* start[kTjColumns];
+    for (int k = 0; k < kTjColumns; k++) { start[k] = p; p += fh->colBytes[k]; }
+
+    // x e y predicen con las velocidades anteriores: primero posiciones, después velocidades
+    bool ok = true;
+    for (int pass = 0; pass < 2; pass++) {
+        #pragma omp parallel for schedule(static, 1) reduction(&&:ok)
+        for (int j = 0; j < 2; j++) {
+            const int k = pass * 2 + j;    // kTjX, kTjY | kTjVX, kTjVY
+            const Sint32* vel = (pass == 0) ? R.q[kTjVX + j].data() : nullptr;
+            ok = trajDecodeColumn(start[k], start[k] + fh->colBytes[k], R.q[k].data(), n, vel, fh->advanceFx) && ok;
+        }
+    }
+    return ok;
+}
+
+// Deja en q el estado del frame f (0 <= f < frames)
+static bool trajSeek(TrajReader& R, int f) {
+    if (f == R.current) return true;
+    int from = f;
+    while (!R.index[from].key) from--;
+    if (R.current >= from && R.current < f) from = R.current + 1;   // seguir desde el actual
+    for (int k = from; k <= f; k++) {
+        if (!trajDecodeFrame(R, k)) {
+            std::cerr << "[warn] --replay: frame " << k << " corrupto\n";
+            R.current = -1;
+            return false;
+        }
+    }
+    R.current = f;
+    return true;
+}
+
+static DrawView trajView(TrajReader& R) {
+    const int n = (int)R.q[kTjX].size();
+    const float inv = 1.f / R.h->scale[kTjX];
+    R.x.resize(n); R.y.resize(n);
+    #pragma omp parallel for simd schedule(static)
+    for (int i = 0; i < n; i++) {
+        R.x[i] = float(R.q[kTjX][i]) * inv;
+        R.y[i] = float(R.q[kTjY][i]) * inv;
+    }
+    DrawView v;
+    v.x = R.x.data(); v.y = R.y.data(); v.color = R.color.data();
+    v.n = n; v.radius = R.h->satRadius;
+    v.mains = &R.mains;
+    return v;
+}
+
+// --bench-mode=sim|raster con --replay: mide decodificar (y dibujar) los frames en orden
+static int runReplayBenchmark(const SimParams& P) {
+    TrajReader& R = gReplay;
+    const bool raster = (P.benchMode == BenchMode::RASTER);
+    AlignedVec<Uint32> frame;
+    if (raster) frame.resize((size_t)P.width * (size_t)P.height);
+    const Uint32 bg = packRGBA(10, 14, 20, 255);
+    const int frames = (int)R.index.size();
+
+    double decodeMs = 0.0, rasterMs = 0.0;
+    const double t0 = omp_get_wtime();
+    for (int f = 0; f < P.benchmarkFrames; f++) {
+        teleBeginFrame(gTele);
+        const double a = omp_get_wtime();
+        if (!trajSeek(R, f % frames)) return 1;
+        const DrawView v = trajView(R);
+        const double b = omp_get_wtime();
+        decodeMs += (b - a) * 1000.0;
+        teleMark(gTele, TP_STEP);
+        if (raster) {
+            rasterLayer(frame.data(), v, P, &bg);
+            rasterMs += (omp_get_wtime() - b) * 1000.0;
+            teleMark(gTele, TP_RASTER);
+        }
+        teleEndFrame(gTele);
+    }
+    const double ms = (omp_get_wtime() - t0) * 1000.0;
+    std::cout << "[Benchmark] Modo: replay" << (raster ? "+raster" : "") << "  Frames grabados: " << frames
+              << "  N: " << R.q[kTjX].size() << "  Frames: " << P.benchmarkFrames
+              << "  Tiempo total: " << ms << " ms  Avg por frame: " << (ms / P.benchmarkFrames) << " ms\n";
+    std::cout << "[Benchmark] decode: " << (decodeMs / P.benchmarkFrames) << " ms/frame";
+    if (raster) std::cout << "  raster: " << (rasterMs / P.benchmarkFrames) << " ms/frame";
+    std::cout << "\n";
+    telePrint(gTele);
+    if (!P.telemetryOut.empty()) teleWriteFiles(gTele, P.telemetryOut);
+    return 0;
+}
 
-        s.x += s.vx * dt;
-        s.y += s.vy * dt;
+// Ventana de replay. Espacio: pausa; Izq/Der: +-1 frame; RePág/AvPág: +-keyframe
+// (60 frames); Inicio/Fin; Arriba/Abajo: velocidad x2 / /2; F, D y E como en la simulación.
+static void runReplay(SDL_Renderer* ren, SimParams& P) {
+    TrajReader& R = gReplay;
+    const int frames = (int)R.index.size();
+    const double recordedHz = double(R.h->simHz) / double(std::max(1u, R.h->everyK));
+    double head = 0.0, speed = 1.0;
+    bool paused = false, running = true, showFPSPanel = false;
+    Uint64 now = SDL_GetPerformanceCounter();
+    const Uint64 freq = SDL_GetPerformanceFrequency();
+
+    while (running) {
+        Uint64 last = now; now = SDL_GetPerformanceCounter();
+        const float frameDt = clampf(float(now - last) / float(freq), 0.f, 0.25f);
+        teleBeginFrame(gTele);
+
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) running = false;
+            else if (e.type == SDL_KEYDOWN) {
+                const bool shift = (SDL_GetModState() & KMOD_SHIFT) != 0;
+                switch (e.key.keysym.sym) {
+                    case SDLK_ESCAPE:   running = false; break;
+                    case SDLK_SPACE:    paused = !paused; break;
+                    case SDLK_RIGHT:    head = std::floor(head) + 1; paused = true; break;
+                    case SDLK_LEFT:     head = std::floor(head) - 1; paused = true; break;
+                    case SDLK_PAGEUP:   head -= kTrajKeyEvery; break;
+                    case SDLK_PAGEDOWN: head += kTrajKeyEvery; break;
+                    case SDLK_HOME:     head = 0; break;
+                    case SDLK_END:      head = frames - 1; break;
+                    case SDLK_UP:       speed = std::min(64.0, speed * 2); break;
+                    case SDLK_DOWN:     speed = std::max(0.125, speed / 2); break;
+                    case SDLK_f:        showFPSPanel = !showFPSPanel; break;
+                    case SDLK_d:
+                        P.renderMode = (P.renderMode == RenderMode::DENSITY) ? RenderMode::CIRCLES : RenderMode::DENSITY;
+                        break;
+                    case SDLK_e: P.densityExposure = clampf(P.densityExposure * (shift ? 0.8f : 1.25f), 0.1f, 20.f); break;
+                    default: break;
+                }
+            }
+        }
+        teleMark(gTele, TP_EVENTS);
 
-        bounceWalls(s, p);
+        if (!paused) head += frameDt * recordedHz * speed;
+        if (head >= frames - 1) { head = frames - 1; paused = true; }
+        if (head < 0) head = 0;
+        if (!trajSeek(R, (int)head)) break;
+        const DrawView view = trajView(R);
+        teleMark(gTele, TP_STEP);
 
-        checkEject(s, S.mainA, p);
-        checkEject(s, S.mainB, p);
-        checkEject(s, S.mainA2, p);
-        checkEject(s, S.mainB2, p);
+        renderSim(ren, view, P, &gTele);
+        char info[128];
+        std::snprintf(info, sizeof info, "REPLAY  frame %d/%d  paso %llu  x%g%s", (int)head + 1, frames,
+                      (unsigned long long)R.index[(int)head].step, speed, paused ? "  [pausa]" : "");
+        drawText(ren, 12, 10, SDL_Color{160,210,255,255}, info);
+        if (showFPSPanel) renderFPSOverlay(ren, gTele, P.width, P.height);
+        teleMark(gTele, TP_OVERLAY);
+        SDL_RenderPresent(ren);
+        teleMark(gTele, TP_PRESENT);
+        teleEndFrame(gTele);
     }
+    if (!P.telemetryOut.empty()) teleWriteFiles(gTele, P.telemetryOut);
+}
+
+static void closeSDL(SDL_Window* win, SDL_Renderer* ren) {
+    destroyGlyphAtlas(gAtlas);
+    if (gFont) TTF_CloseFont(gFont);
+    TTF_Quit();
+    destroyFramebuffer(gFrame);
+    unmapFile(gCheckpoint);
+    trajClose(gReplay);
+    SDL_DestroyRenderer(ren);
+    SDL_DestroyWindow(win);
+    SDL_Quit();
 }
 
 // ---------------- main ----------------
+// SCREENSAVER_NO_MAIN: para incluir este archivo desde microbench.cpp
+#ifndef SCREENSAVER_NO_MAIN
 int main(int argc, char** argv) {
-    std::srand(unsigned(std::time(nullptr)));
     SimParams P;
     parseArgs(argc, argv, P);
+    resolveCompact(P);
+    // El checkpoint trae su propia física, resolución, N y semilla
+    if (!P.loadCheckpoint.empty() && !openCheckpoint(P)) return 1;
+    // El replay dibuja con la resolución y el radio de la grabación
+    if (!P.replay.empty()) {
+        if (!trajOpen(gReplay, P.replay)) return 1;
+        P.width = gReplay.h->width; P.height = gReplay.h->height;
+        P.satRadius = gReplay.h->satRadius;
+    }
+    if (P.seed == 0) P.seed = Uint64(std::time(nullptr));
 
     // Ventana mínima 640x480
     P.width = std::max(P.width, 640);
     P.height = std::max(P.height, 480);
+    P.simd = resolveSimd(P.simd);
+    P.backend = resolveBackend(P.backend);
+    if (!std::getenv("OMP_SCHEDULE")) omp_set_schedule(omp_sched_static, 0);
+
+    if (P.benchmark && P.benchMode != BenchMode::FULL) {
+        const int rc = gReplay.file.data ? runReplayBenchmark(P) : runHeadlessBenchmark(P);
+        unmapFile(gCheckpoint);
+        trajClose(gReplay);
+        return rc;
+    }
 
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
         std::cerr << "SDL_Init error: " << SDL_GetError() << "\n";
@@ -534,8 +4303,9 @@ int main(int argc, char** argv) {
         if (!gFont) std::cerr << "TTF_OpenFont: " << TTF_GetError() << " (usando fallback de bloques)\n";
     }
 
+    const std::string title = std::string("Screensaver (SDL2, ") + backendLabel(P.backend) + ") — Verde atrae / Rojo repele";
     SDL_Window* win = SDL_CreateWindow(
-        "Screensaver Paralelo (SDL2) — Verde atrae / Rojo repele",
+        title.c_str(),
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         P.width, P.height, SDL_WINDOW_SHOWN);
     if (!win) { std::cerr << "SDL_CreateWindow error: " << SDL_GetError() << "\n"; return 1; }
@@ -544,99 +4314,163 @@ int main(int argc, char** argv) {
     if (!ren) { std::cerr << "SDL_CreateRenderer error: " << SDL_GetError() << "\n"; return 1; }
     SDL_RenderSetLogicalSize(ren, P.width, P.height);
     SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND); // necesario para los overlays
+    if (gFont) buildGlyphAtlas(ren, gFont);
+
+    // Replay de una grabación (--benchmark full no aplica: se mide con --bench-mode=)
+    if (gReplay.file.data) {
+        runReplay(ren, P);
+        closeSDL(win, ren);
+        return 0;
+    }
 
     // Benchmark mode
     if (P.benchmark) {
         SimState S;
-        initSim(S, P);
+        startSim(S, P);
+        if (!P.recordOut.empty()) recStart(gRec, P.recordOut, P.width, P.height, P.simHz);
+        if (!P.trajOut.empty()) trajStart(gTraj, P.trajOut, P);
 
         Uint64 t0 = SDL_GetPerformanceCounter();
 
         for (int frame = 0; frame < P.benchmarkFrames; frame++) {
-            // dt fijo (~16 ms ≈ 60 FPS target)
-            float dt = 0.016f;
+            // paso fijo de la simulación (--simHz)
+            float dt = 1.f / P.simHz;
+            teleBeginFrame(gTele);
             step(S, P, dt);
+            trajAfterStep(gTraj, S, P);
+            teleMark(gTele, TP_STEP);
 
-            renderSim(ren, S, P, {}); // {} = sin historial de FPS
+            renderSim(ren, viewOf(S), P, nullptr); // sin barra de FPS
+            teleMark(gTele, TP_OVERLAY);
             SDL_RenderPresent(ren);
+            teleMark(gTele, TP_PRESENT);
+            teleEndFrame(gTele);
         }
 
         Uint64 t1 = SDL_GetPerformanceCounter();
         double ms = (t1 - t0) * 1000.0 / SDL_GetPerformanceFrequency();
-        std::cout << "[Benchmark] Frames: " << P.benchmarkFrames
+        recStop(gRec);
+        trajStop(gTraj);
+        if (!P.saveCheckpoint.empty()) saveCheckpoint(S, P, P.saveCheckpoint);
+        std::cout << "[Benchmark] Modo: full  Backend: " << backendLabel(P.backend) << "  SIMD: " << simdLabel(P.simd)
+                << "  Render: " << renderModeLabel(P.renderMode) << "  N: " << P.N << "  Seed: " << P.seed
+                << "  Frames: " << P.benchmarkFrames
                 << "  Tiempo total: " << ms << " ms"
                 << "  Avg por frame: " << (ms / P.benchmarkFrames) << " ms\n";
+        printOptionalStats(P);
+        telePrint(gTele);
+        if (!P.telemetryOut.empty()) teleWriteFiles(gTele, P.telemetryOut);
+        if (P.benchJson) printBenchJson(P, "full", ms, teleStats(gTele, TP_STEP).mean, teleStats(gTele, TP_RASTER).mean);
 
-        if (gFont) TTF_CloseFont(gFont);
-        TTF_Quit();
-        SDL_DestroyRenderer(ren);
-        SDL_DestroyWindow(win);
-        SDL_Quit();
+        closeSDL(win, ren);
         return 0;
     }
 
-    // Menú
-    Mode mode = runMenu(win, ren, P);
+    // Menú (con --load-checkpoint se arranca directo: los parámetros vienen del archivo)
+    Mode mode = gCheckpoint.data ? Mode::RUN : runMenu(win, ren, P);
     if (mode == Mode::QUIT) {
-        if (gFont) TTF_CloseFont(gFont);
-        TTF_Quit();
-        SDL_DestroyRenderer(ren);
-        SDL_DestroyWindow(win);
-        SDL_Quit();
+        closeSDL(win, ren);
         return 0;
     }
 
     // Sim
     SimState S;
-    initSim(S, P);
+    startSim(S, P);
+    if (!P.recordOut.empty()) recStart(gRec, P.recordOut, P.width, P.height, P.simHz);
+    if (!P.trajOut.empty()) trajStart(gTraj, P.trajOut, P);
 
     bool running = true;
     bool showFPSPanel = false;             // <--- tecla F
     Uint64 now = SDL_GetPerformanceCounter();
     Uint64 freq = SDL_GetPerformanceFrequency();
 
-    std::vector<float> fpsHist10; fpsHist10.reserve(10);
-    std::vector<float> fpsLog;    fpsLog.reserve(300);
+    // Acumulador de paso fijo
+    const float h = 1.f / P.simHz;
+    float acc = 0.f;
+    Interpolator interp;
+    interp.snapshot(S);
+
+    // Con --pipeline, S pasa a ser del hilo de simulación hasta pipeStop()
+    SimPipeline pipe;
+    if (P.pipeline) pipeStart(pipe, S, P);
 
     while (running) {
-        // dt (cap a ~33ms por estabilidad)
+        // tiempo real del frame (cap a 250 ms para no entrar en espiral tras una pausa)
         Uint64 last = now; now = SDL_GetPerformanceCounter();
-        float dt = float(now - last) / float(freq);
-        dt = clampf(dt, 0.f, 0.033f);
+        float frameDt = float(now - last) / float(freq);
+        frameDt = clampf(frameDt, 0.f, 0.25f);
+        teleBeginFrame(gTele);
 
         // eventos
+        bool reset = false;
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) running = false;
             else if (e.type == SDL_KEYDOWN) {
                 if (e.key.keysym.sym == SDLK_ESCAPE) running = false;
-                if (e.key.keysym.sym == SDLK_r) { initSim(S, P); }
+                if (e.key.keysym.sym == SDLK_r) { reset = true; acc = 0.f; }
                 if (e.key.keysym.sym == SDLK_f) { showFPSPanel = !showFPSPanel; } // toggle overlay
+                if (e.key.keysym.sym == SDLK_d) {  // círculos <-> densidad
+                    P.renderMode = (P.renderMode == RenderMode::DENSITY) ? RenderMode::CIRCLES : RenderMode::DENSITY;
+                }
+                if (e.key.keysym.sym == SDLK_e) {  // exposición del mapa de calor (Shift baja)
+                    const bool shift = (SDL_GetModState() & KMOD_SHIFT) != 0;
+                    P.densityExposure = clampf(P.densityExposure * (shift ? 0.8f : 1.25f), 0.1f, 20.f);
+                }
             }
         }
 
-        // step
-        step(S, P, dt);
+        // step: tantos pasos fijos como quepan en el acumulador (máx. maxSubsteps;
+        // si la máquina no da abasto se descarta el tiempo sobrante)
+        teleMark(gTele, TP_EVENTS);
+        acc += frameDt;
+        int substeps = int(acc / h);
+        if (substeps > P.maxSubsteps) { substeps = P.maxSubsteps; acc = substeps * h; }
+        acc -= substeps * h;
+        const float alpha = clampf(acc / h, 0.f, 1.f);
 
-        // FPS
-        float instFPS = (dt > 0.f) ? (1.f/dt) : 0.f;
-        fpsHist10.push_back(instFPS);
-        if (fpsHist10.size() > 10) fpsHist10.erase(fpsHist10.begin());
-        fpsLog.push_back(instFPS);
-        if (fpsLog.size() > 300) fpsLog.erase(fpsLog.begin()); // guardamos los últimos 300
+        DrawView view;
+        if (P.pipeline) {
+            // toma el último resultado listo y encarga el siguiente; el dibujo de
+            // abajo se solapa con esos pasos (se muestra con un frame de retraso)
+            pipeCollect(pipe, false);
+            if (substeps > 0 || reset) pipePost(pipe, substeps, reset);
+            PipeFrame& F = pipe.frames[pipe.front];
+            view = P.interpolate ? F.interp.view(F.view(), alpha) : F.view();
+        } else {
+            if (reset) { startSim(S, P); interp.snapshot(S); }
+            for (int k = 0; k < substeps; k++) {
+                if (reorderDue(P)) {
+                    teleMark(gTele, TP_STEP);
+                    reorderSats(S.sats, P);
+                    teleMark(gTele, TP_REORDER);
+                }
+                if (k == substeps - 1 && P.interpolate) interp.snapshot(S);
+                step(S, P, h);
+                trajAfterStep(gTraj, S, P);
+            }
+            view = P.interpolate ? interp.view(S, alpha) : viewOf(S);
+        }
+        teleMark(gTele, TP_STEP);
 
-        // render (presentamos una sola vez al final)
-        renderSim(ren, S, P, fpsHist10);
+        // render (presentamos una sola vez al final); la barra y el panel de FPS
+        // leen el ring de telemetría
+        renderSim(ren, view, P, &gTele);
         if (showFPSPanel) {
-            renderFPSOverlay(ren, fpsLog, P.width, P.height);
+            renderFPSOverlay(ren, gTele, P.width, P.height);
         }
+        teleMark(gTele, TP_OVERLAY);
         SDL_RenderPresent(ren);
+        teleMark(gTele, TP_PRESENT);
+        teleEndFrame(gTele);
     }
+    if (P.pipeline) pipeStop(pipe);
+    recStop(gRec);
+    trajStop(gTraj);
+    if (!P.saveCheckpoint.empty()) saveCheckpoint(S, P, P.saveCheckpoint);
+    if (!P.telemetryOut.empty()) teleWriteFiles(gTele, P.telemetryOut);
 
-    if (gFont) TTF_CloseFont(gFont);
-    TTF_Quit();
-    SDL_DestroyRenderer(ren);
-    SDL_DestroyWindow(win);
-    SDL_Quit();
+    closeSDL(win, ren);
     return 0;
 }
+#endif // SCREENSAVER_NO_MAIN